@@ -0,0 +1,199 @@
+// stringswitch_backends: single-thread lookup throughput of each way to
+// evaluate one switch.
+//
+//   stringswitch_backends [--labels N,N,...] [--lookups N] [--misses PCT]
+//
+// For every label count, a switch over random labels is measured with each of
+// these backends:
+//
+// * `switch`: `evaluate` on the switch itself, its hash map.
+// * `flat`: the switch's frozen `FlatTable`, as direct batch lookups use it.
+// * `native`: a `CompiledSwitch` running generated machine code.
+// * `interpreted`: a `CompiledSwitch` with `JitMode::k_Interpret`.
+// * `tiered`: a `TieredSwitch` past its promotion threshold, once it has
+//   decided whether to promote; reported as `tiered (kept)` if it stayed on
+//   the hash table.
+//
+// Keys are drawn at random from the labels, with `--misses` percent replaced
+// by strings that match none, and looked up in the same order by every
+// backend. The report gives millions of lookups per second, and each
+// backend's speed relative to `switch`.
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_batch.h"
+#include "stringswitch/stringswitch_jit.h"
+#include "stringswitch/stringswitch_tiered.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using Switch = decltype(stringswitch::StringSwitch<std::uint32_t>::create()
+                            .on_default(std::uint32_t{0}));
+
+// Where the results of the lookups end up, so they are not optimized away.
+volatile std::uint64_t g_sink;
+
+struct Options {
+  std::vector<std::size_t> labels = {10, 100, 1000, 10000, 100000};
+  std::size_t lookups = 4'000'000;
+  std::size_t misses = 10;
+};
+
+[[noreturn]] void usage(const char *message) {
+  std::cerr << "stringswitch_backends: " << message << "\n"
+            << "usage: stringswitch_backends [--labels N,N,...] "
+               "[--lookups N] [--misses PCT]\n";
+  std::exit(2);
+}
+
+Options parse_options(int argc, char **argv) {
+  Options options;
+  for (int idx = 1; idx < argc; ++idx) {
+    const std::string_view arg = argv[idx];
+    auto value = [&]() -> const char * {
+      if (idx + 1 == argc) {
+        usage("missing option value");
+      }
+      return argv[++idx];
+    };
+    if (arg == "--labels") {
+      options.labels.clear();
+      const char *list = value();
+      while (*list != '\0') {
+        char *end;
+        options.labels.push_back(std::strtoul(list, &end, 10));
+        if (end == list || options.labels.back() == 0) {
+          usage("--labels takes a list of positive counts");
+        }
+        list = *end == ',' ? end + 1 : end;
+      }
+    } else if (arg == "--lookups") {
+      options.lookups = std::strtoul(value(), nullptr, 10);
+    } else if (arg == "--misses") {
+      options.misses = std::strtoul(value(), nullptr, 10);
+    } else {
+      usage("unknown option");
+    }
+  }
+  if (options.lookups == 0 || options.misses > 100) {
+    usage("--lookups must be positive and --misses at most 100");
+  }
+  return options;
+}
+
+// Identifier-like strings of 3 to 24 bytes.
+std::string random_label(std::mt19937_64 &random) {
+  static constexpr std::string_view k_Alphabet =
+      "abcdefghijklmnopqrstuvwxyz0123456789_.";
+  std::string label(3 + random() % 22, ' ');
+  for (char &c : label) {
+    c = k_Alphabet[random() % k_Alphabet.size()];
+  }
+  return label;
+}
+
+template <class Backend>
+double measure(const Backend &backend, const std::vector<std::string> &keys) {
+  std::uint64_t sum = 0;
+  // Once to warm up, then timed.
+  for (const std::string &key : keys) {
+    sum += backend(key);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  for (const std::string &key : keys) {
+    sum += backend(key);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  g_sink = sum;
+  return elapsed.count() > 0 ? keys.size() / elapsed.count() / 1e6 : 0;
+}
+
+void run(std::size_t num_labels, const Options &options) {
+  std::mt19937_64 random(num_labels);
+  std::unordered_set<std::string> unique;
+  while (unique.size() != num_labels) {
+    unique.insert(random_label(random));
+  }
+  const std::vector<std::string> labels(unique.begin(), unique.end());
+  auto sw = stringswitch::StringSwitch<std::uint32_t>::create().on_default(
+      std::uint32_t{0});
+  for (std::size_t idx = 0; idx != labels.size(); ++idx) {
+    sw.when(labels[idx], static_cast<std::uint32_t>(idx + 1));
+  }
+
+  std::vector<std::string> keys(options.lookups);
+  for (std::string &key : keys) {
+    key = random() % 100 < options.misses
+              ? random_label(random) + "!"
+              : labels[random() % labels.size()];
+  }
+
+  const auto &flat = stringswitch::detail::SwitchAccess::flat_table(sw);
+  const stringswitch::CompiledSwitch native(sw);
+  const stringswitch::CompiledSwitch interpreted(
+      sw, stringswitch::JitMode::k_Interpret);
+  const stringswitch::TieredSwitch<Switch> tiered(sw, 1);
+  tiered.evaluate(keys[0]);
+  // Promotion is decided in the background; a switch that has not promoted
+  // after a generous wait has declined to.
+  for (int wait = 0; wait != 200 && !tiered.is_promoted(); ++wait) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  struct Result {
+    const char *name;
+    double rate;
+  };
+  const Result results[] = {
+      {"switch",
+       measure([&](std::string_view key) { return sw.evaluate(key); }, keys)},
+      {"flat",
+       measure(
+           [&](std::string_view key) {
+             const std::uint32_t *found = flat.find(key);
+             return found != nullptr ? *found : 0;
+           },
+           keys)},
+      {native.is_native() ? "native" : "native (n/a)",
+       measure([&](std::string_view key) { return native.evaluate(key); },
+               keys)},
+      {"interpreted",
+       measure(
+           [&](std::string_view key) { return interpreted.evaluate(key); },
+           keys)},
+      {tiered.is_promoted() ? "tiered" : "tiered (kept)",
+       measure([&](std::string_view key) { return tiered.evaluate(key); },
+               keys)},
+  };
+  for (const Result &result : results) {
+    std::printf("%8zu  %-12s  %8.1f M/s  %5.2fx\n",
+                num_labels,
+                result.name,
+                result.rate,
+                results[0].rate > 0 ? result.rate / results[0].rate : 0);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Options options = parse_options(argc, argv);
+  std::printf("%8s  %-12s  %10s  %6s\n", "labels", "backend", "lookups",
+              "speed");
+  for (std::size_t num_labels : options.labels) {
+    run(num_labels, options);
+  }
+  return 0;
+}
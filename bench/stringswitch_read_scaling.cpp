@@ -0,0 +1,487 @@
+// stringswitch_read_scaling: lookup throughput of switches read by many
+// threads at once.
+//
+//   stringswitch_read_scaling [--threads N,N,...] [--labels N]
+//                             [--lookups N] [--no-pin]
+//
+// Every thread count is measured with each of these setups:
+//
+// * `shared`: all threads read one switch.
+// * `replicated`: each thread reads its own switch, built on that thread.
+// * `compiled`: all threads read one `CompiledSwitch`.
+// * `shared+atomic`: as `shared`, counting lookups in one atomic counter,
+//   the way a naive statistics policy would.
+// * `shared+packed`: per-thread counters packed next to each other.
+// * `shared+padded`: per-thread counters on cache lines of their own.
+// * `shared+batch`: all threads run small `evaluate_batch` calls on one
+//   switch, which reach its frozen table through its lazily built index.
+// * `replicated+batch`: as `shared+batch`, on a switch per thread.
+//
+// For each it prints total and per-thread throughput, and the scaling
+// efficiency: throughput over the thread count times the one-thread
+// throughput of the same setup. Reads that scale share nothing writable, so
+// `shared` should stay close to `replicated`; when it falls behind, or a
+// counter setup falls behind `shared`, the report flags the cache-line
+// contention that explains it.
+//
+// Threads are pinned to one CPU each, round robin over the CPUs the process
+// may run on, unless `--no-pin` is given or the platform does not support it.
+// Threads that could not be pinned are reported.
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_batch.h"
+#include "stringswitch/stringswitch_jit.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Switch = decltype(stringswitch::StringSwitch<std::uint32_t>::create()
+                            .on_default(std::uint32_t{0}));
+
+// Wider than a cache line on the targets we care about, so padded counters
+// never share one, even with adjacent-line prefetching.
+constexpr std::size_t k_CounterPadding = 128;
+
+// Rows per `evaluate_batch` call in the batch setups: small, so the per-call
+// cost of reaching the switch's frozen table shows.
+constexpr std::size_t k_BatchSize = 16;
+
+// Where the results of the lookups end up, so they are not optimized away.
+volatile std::uint64_t g_sink;
+
+struct Options {
+  std::vector<std::size_t> threads;
+  std::size_t labels = 1000;
+  std::size_t lookups = 2'000'000;
+  bool pin = true;
+};
+
+[[noreturn]] void usage(const char *message) {
+  std::cerr << "stringswitch_read_scaling: " << message << "\n"
+            << "usage: stringswitch_read_scaling [--threads N,N,...] "
+               "[--labels N] [--lookups N] [--no-pin]\n";
+  std::exit(2);
+}
+
+// 1, 2, 4, ... up to and including the hardware concurrency.
+std::vector<std::size_t> default_thread_counts() {
+  const std::size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::size_t> counts;
+  for (std::size_t count = 1; count < cpus; count *= 2) {
+    counts.push_back(count);
+  }
+  counts.push_back(cpus);
+  return counts;
+}
+
+Options parse_options(int argc, char **argv) {
+  Options options;
+  for (int idx = 1; idx < argc; ++idx) {
+    const std::string_view arg = argv[idx];
+    auto value = [&]() -> const char * {
+      if (idx + 1 == argc) {
+        usage("missing option value");
+      }
+      return argv[++idx];
+    };
+    if (arg == "--threads") {
+      const char *list = value();
+      while (*list != '\0') {
+        char *end;
+        options.threads.push_back(std::strtoul(list, &end, 10));
+        if (end == list || options.threads.back() == 0) {
+          usage("--threads takes a list of positive counts");
+        }
+        list = *end == ',' ? end + 1 : end;
+      }
+    } else if (arg == "--labels") {
+      options.labels = std::strtoul(value(), nullptr, 10);
+    } else if (arg == "--lookups") {
+      options.lookups = std::strtoul(value(), nullptr, 10);
+    } else if (arg == "--no-pin") {
+      options.pin = false;
+    } else {
+      usage("unknown option");
+    }
+  }
+  if (options.threads.empty()) {
+    options.threads = default_thread_counts();
+  }
+  if (options.labels == 0 || options.lookups == 0) {
+    usage("--labels and --lookups must be positive");
+  }
+  return options;
+}
+
+std::string make_label(std::size_t index) {
+  return "setting." + std::to_string(index * 2654435761u % 1000003) + ".value";
+}
+
+Switch make_switch(std::size_t labels) {
+  auto sw = stringswitch::StringSwitch<std::uint32_t>::create().on_default(
+      std::uint32_t{0});
+  for (std::size_t idx = 0; idx != labels; ++idx) {
+    sw.when(make_label(idx), static_cast<std::uint32_t>(idx + 1));
+  }
+  return sw;
+}
+
+// A per-thread stream of parameters, one in eight missing, so each thread
+// walks the table in its own order.
+std::vector<std::string> make_params(std::size_t labels, std::size_t seed) {
+  std::vector<std::string> params;
+  std::uint64_t state = seed * 0x9E3779B97F4A7C15u + 1;
+  for (std::size_t idx = 0; idx != 4096; ++idx) {
+    state = state * 6364136223846793005u + 1442695040888963407u;
+    const std::size_t pick = static_cast<std::size_t>(state >> 33);
+    params.push_back(pick % 8 == 0 ? "missing." + std::to_string(pick)
+                                   : make_label(pick % labels));
+  }
+  return params;
+}
+
+// The CPUs this process may run on, which in a container or under
+// `taskset` can be fewer than the hardware has. Empty if unknown.
+std::vector<int> allowed_cpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu != CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+// Pin the calling thread to one of `cpus`, round robin. Returns whether it
+// worked.
+bool pin_to_cpu(std::size_t thread_index, const std::vector<int> &cpus) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpus[thread_index % cpus.size()], &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)thread_index;
+  (void)cpus;
+  return false;
+#endif
+}
+
+enum class Setup {
+  k_Shared,
+  k_Replicated,
+  k_Compiled,
+  k_SharedAtomic,
+  k_SharedPacked,
+  k_SharedPadded,
+  k_SharedBatch,
+  k_ReplicatedBatch,
+};
+
+constexpr Setup k_Setups[] = {
+    Setup::k_Shared,
+    Setup::k_Replicated,
+    Setup::k_Compiled,
+    Setup::k_SharedAtomic,
+    Setup::k_SharedPacked,
+    Setup::k_SharedPadded,
+    Setup::k_SharedBatch,
+    Setup::k_ReplicatedBatch,
+};
+
+const char *setup_name(Setup setup) {
+  switch (setup) {
+  case Setup::k_Shared:
+    return "shared";
+  case Setup::k_Replicated:
+    return "replicated";
+  case Setup::k_Compiled:
+    return "compiled";
+  case Setup::k_SharedAtomic:
+    return "shared+atomic";
+  case Setup::k_SharedPacked:
+    return "shared+packed";
+  case Setup::k_SharedPadded:
+    return "shared+padded";
+  case Setup::k_SharedBatch:
+    return "shared+batch";
+  case Setup::k_ReplicatedBatch:
+    return "replicated+batch";
+  }
+  return "";
+}
+
+struct PaddedCounter {
+  alignas(k_CounterPadding) std::atomic<std::uint64_t> value{0};
+};
+
+// What the threads of one run share, besides the switch.
+struct Counters {
+  explicit Counters(std::size_t threads) : packed(threads), padded(threads) {}
+
+  std::atomic<std::uint64_t> shared{0};
+  std::vector<std::atomic<std::uint64_t>> packed;
+  std::vector<PaddedCounter> padded;
+};
+
+// Looks up `count` parameters, cycling through `params`, and returns the sum
+// of the results so the lookups cannot be optimized away. `count_lookup` is
+// called once per lookup.
+template <class Lookup, class CountLookup>
+std::uint64_t run_lookups(const std::vector<std::string> &params,
+                          std::size_t count,
+                          Lookup lookup,
+                          CountLookup count_lookup) {
+  std::uint64_t sum = 0;
+  std::size_t next = 0;
+  for (std::size_t idx = 0; idx != count; ++idx) {
+    sum += lookup(params[next]);
+    count_lookup();
+    next = next + 1 == params.size() ? 0 : next + 1;
+  }
+  return sum;
+}
+
+// As `run_lookups`, `k_BatchSize` parameters at a time with `evaluate_batch`.
+std::uint64_t run_batches(const std::vector<std::string_view> &params,
+                          std::size_t count,
+                          const Switch &sw) {
+  std::uint64_t sum = 0;
+  std::uint32_t out[k_BatchSize];
+  std::size_t next = 0;
+  for (std::size_t idx = 0; idx < count; idx += k_BatchSize) {
+    stringswitch::evaluate_batch(
+        std::span(params).subspan(next, k_BatchSize),
+        sw,
+        std::span(out),
+        stringswitch::BatchStrategy::k_Direct);
+    for (std::uint32_t result : out) {
+      sum += result;
+    }
+    next = next + k_BatchSize == params.size() ? 0 : next + k_BatchSize;
+  }
+  return sum;
+}
+
+// Lookups per second, over all threads, of one setup at one thread count.
+// Threads that could not be pinned are added to `pin_failures`.
+double measure(Setup setup,
+               std::size_t threads,
+               const Switch &sw,
+               const stringswitch::CompiledSwitch<Switch> &compiled,
+               const Options &options,
+               const std::vector<int> &cpus,
+               std::atomic<std::size_t> &pin_failures) {
+  Counters counters(threads);
+  std::vector<std::vector<std::string>> params;
+  for (std::size_t idx = 0; idx != threads; ++idx) {
+    params.push_back(make_params(options.labels, idx));
+  }
+  std::latch ready(static_cast<std::ptrdiff_t>(threads) + 1);
+  std::latch start(1);
+  std::vector<double> seconds(threads);
+  std::atomic<std::uint64_t> checksum{0};
+
+  std::vector<std::thread> workers;
+  for (std::size_t idx = 0; idx != threads; ++idx) {
+    workers.emplace_back([&, idx] {
+      if (options.pin && !pin_to_cpu(idx, cpus)) {
+        pin_failures.fetch_add(1, std::memory_order_relaxed);
+      }
+      // Built after pinning, so its memory is local to the thread's node.
+      // Built from scratch rather than copied: a copy would share the
+      // original's lazily built indexes.
+      std::unique_ptr<const Switch> replica;
+      if (setup == Setup::k_Replicated ||
+          setup == Setup::k_ReplicatedBatch) {
+        replica = std::make_unique<const Switch>(make_switch(options.labels));
+      }
+      const Switch &mine = replica ? *replica : sw;
+      auto evaluate = [&](std::string_view param) {
+        return mine.evaluate(param);
+      };
+      auto evaluate_compiled = [&](std::string_view param) {
+        return compiled.evaluate(param);
+      };
+      const std::vector<std::string> &mine_params = params[idx];
+      const std::vector<std::string_view> mine_views(mine_params.begin(),
+                                                     mine_params.end());
+      const std::size_t count = options.lookups;
+      ready.count_down();
+      start.wait();
+
+      const auto begin = std::chrono::steady_clock::now();
+      std::uint64_t sum = 0;
+      switch (setup) {
+      case Setup::k_Shared:
+      case Setup::k_Replicated:
+        sum = run_lookups(mine_params, count, evaluate, [] {});
+        break;
+      case Setup::k_Compiled:
+        sum = run_lookups(mine_params, count, evaluate_compiled, [] {});
+        break;
+      case Setup::k_SharedAtomic:
+        sum = run_lookups(mine_params, count, evaluate, [&] {
+          counters.shared.fetch_add(1, std::memory_order_relaxed);
+        });
+        break;
+      case Setup::k_SharedPacked:
+        sum = run_lookups(mine_params, count, evaluate, [&] {
+          counters.packed[idx].fetch_add(1, std::memory_order_relaxed);
+        });
+        break;
+      case Setup::k_SharedPadded:
+        sum = run_lookups(mine_params, count, evaluate, [&] {
+          counters.padded[idx].value.fetch_add(1, std::memory_order_relaxed);
+        });
+        break;
+      case Setup::k_SharedBatch:
+      case Setup::k_ReplicatedBatch:
+        sum = run_batches(mine_views, count, mine);
+        break;
+      }
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - begin;
+      seconds[idx] = elapsed.count();
+      checksum.fetch_add(sum, std::memory_order_relaxed);
+    });
+  }
+  ready.arrive_and_wait();
+  start.count_down();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  g_sink = checksum.load();
+  // The slowest thread bounds the run.
+  const double slowest = *std::max_element(seconds.begin(), seconds.end());
+  return static_cast<double>(threads * options.lookups) / slowest;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Options options = parse_options(argc, argv);
+  const Switch sw = make_switch(options.labels);
+  const stringswitch::CompiledSwitch<Switch> compiled(sw);
+  const std::vector<int> cpus = allowed_cpus();
+  const bool pin = options.pin && !cpus.empty();
+  std::atomic<std::size_t> pin_failures{0};
+  auto measure_setup = [&](Setup setup, std::size_t threads) {
+    Options run_options = options;
+    run_options.pin = pin;
+    return measure(
+        setup, threads, sw, compiled, run_options, cpus, pin_failures);
+  };
+
+  std::printf("%zu labels, %zu lookups per thread, %s, %zu of %u CPUs "
+              "allowed\n",
+              options.labels,
+              options.lookups,
+              pin ? "pinned" : "unpinned",
+              cpus.size(),
+              std::thread::hardware_concurrency());
+  if (options.pin && !pin) {
+    std::fprintf(stderr, "cannot read the allowed CPUs, running unpinned\n");
+  }
+  std::printf("%-17s %8s %14s %14s %11s\n",
+              "setup",
+              "threads",
+              "total Mops/s",
+              "per thread",
+              "efficiency");
+
+  constexpr std::size_t k_NumSetups = std::size(k_Setups);
+  // results[setup][run] in lookups per second.
+  std::vector<std::vector<double>> results(k_NumSetups);
+  for (std::size_t run = 0; run != options.threads.size(); ++run) {
+    const std::size_t threads = options.threads[run];
+    for (std::size_t s = 0; s != k_NumSetups; ++s) {
+      results[s].push_back(measure_setup(k_Setups[s], threads));
+    }
+  }
+
+  for (std::size_t s = 0; s != k_NumSetups; ++s) {
+    const auto one = std::find(options.threads.begin(), options.threads.end(),
+                               std::size_t{1});
+    const double single =
+        one != options.threads.end()
+            ? results[s][one - options.threads.begin()]
+            : measure_setup(k_Setups[s], 1);
+    for (std::size_t run = 0; run != options.threads.size(); ++run) {
+      const std::size_t threads = options.threads[run];
+      const double total = results[s][run];
+      std::printf("%-17s %8zu %14.1f %14.1f %10.0f%%\n",
+                  setup_name(k_Setups[s]),
+                  threads,
+                  total / 1e6,
+                  total / threads / 1e6,
+                  100 * total / (threads * single));
+    }
+  }
+
+  // Contention shows as a setup falling well behind the one it differs from
+  // only by the shared cache lines it writes.
+  constexpr double k_ContentionRatio = 0.8;
+  auto compare = [&](Setup setup, Setup baseline, const char *explanation) {
+    const std::vector<double> &measured =
+        results[static_cast<std::size_t>(setup)];
+    const std::vector<double> &reference =
+        results[static_cast<std::size_t>(baseline)];
+    for (std::size_t run = 0; run != options.threads.size(); ++run) {
+      if (options.threads[run] > 1 &&
+          measured[run] < k_ContentionRatio * reference[run]) {
+        std::printf("contention: %s at %zu threads runs at %.0f%% of %s: %s\n",
+                    setup_name(setup),
+                    options.threads[run],
+                    100 * measured[run] / reference[run],
+                    setup_name(baseline),
+                    explanation);
+        return;
+      }
+    }
+  };
+  compare(Setup::k_Shared,
+          Setup::k_Replicated,
+          "lookups write memory shared between threads");
+  compare(Setup::k_SharedAtomic,
+          Setup::k_Shared,
+          "the shared counter's cache line bounces between cores");
+  compare(Setup::k_SharedPacked,
+          Setup::k_SharedPadded,
+          "per-thread counters falsely share cache lines");
+  compare(Setup::k_SharedBatch,
+          Setup::k_ReplicatedBatch,
+          "reaching the switch's lazily built index writes shared memory, "
+          "such as a reference count");
+  if (pin_failures.load() != 0) {
+    std::printf("warning: %zu threads could not be pinned and ran where the "
+                "scheduler put them\n",
+                pin_failures.load());
+  }
+  return 0;
+}
@@ -58,8 +58,19 @@ namespace stringswitch {
 ///         //  ^ A paramter was already set. Which one to use is ambiguous.
 /// }
 /// ```
-template <typename Result>
-using StringSwitch = detail::StringSwitchImpl<Result>;
+///
+/// The optional `Key` selects what the switch is keyed on, see
+/// stringswitch_keys.h. For example `CompositeKey<2>` keys it on pairs of
+/// strings:
+///
+/// ```cpp
+/// auto codec = StringSwitch<Codec, CompositeKey<2>>::create()
+///                  .when({"GET", "json"}, Codec::k_Json)
+///                  .on_default(Codec::k_Raw)
+///                  .evaluate({method, content_type});
+/// ```
+template <typename Result, typename Key = StringKey>
+using StringSwitch = detail::StringSwitchImpl<Result, void, void, Key>;
 } // namespace stringswitch
 
 #endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_H
@@ -0,0 +1,495 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_BATCH_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_BATCH_H
+
+#include "stringswitch_cpu.h"
+#include "stringswitch_extras.h"
+#include "stringswitch_flat_table.h"
+#include "stringswitch_impl.h"
+#include "stringswitch_outcome_index.h"
+#include "stringswitch_ranges.h"
+#include "stringswitch_sorted_table.h"
+
+#include <algorithm>
+#include <concepts>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace stringswitch {
+
+/// All the positions in a batch that classified to `key`.
+template <class Key>
+struct PartitionBucket {
+  Key key;
+  std::vector<std::size_t> indices;
+};
+
+/// The number of rows in a batch that classified to `key`.
+template <class Key>
+struct HistogramBin {
+  Key key;
+  std::size_t count;
+};
+
+/// How `evaluate_batch` resolves the rows of a batch.
+enum class BatchStrategy {
+  /// Pick a strategy by sampling the batch.
+  k_Auto,
+  /// Look every row up in the switch.
+  k_Direct,
+  /// Look up every distinct row once, and copy the outcome to its duplicates.
+  k_Deduplicate,
+  /// Walk the switch's labels in order alongside a batch sorted in ascending
+  /// order, galloping from each row's label to the next.
+  k_MergeJoin,
+};
+
+namespace detail {
+
+/// A batch of parameters that can be indexed and viewed as strings.
+template <class Range>
+concept StringBatch =
+    std::ranges::random_access_range<Range> &&
+    std::ranges::sized_range<Range> &&
+    std::convertible_to<std::ranges::range_reference_t<Range>,
+                        std::string_view>;
+
+// Assigns a dense ordinal to every distinct outcome of a switch (including the
+// outcome of a miss) so that bulk operations can index plain arrays instead of
+// hashing outcomes once per row. The ordinals of the cases and ranges are
+// derived once and kept with the switch (see `OutcomeIndex`); only the miss is
+// placed per use.
+template <class Switch>
+class OutcomeOrdinals {
+public:
+  using Key = typename Switch::EffectiveResultType;
+  using Result = typename Switch::ResultType;
+
+  explicit OutcomeOrdinals(const Switch &sw)
+      : d_table(SwitchAccess::flat_table(sw)),
+        d_ranges(SwitchAccess::ranges(sw)),
+        d_index(SwitchAccess::outcome_index(sw)),
+        d_miss(SwitchAccess::on_miss(sw)) {
+    if constexpr (std::is_same_v<Key, Result>) {
+      d_miss_ordinal = d_index.find(d_miss);
+    } else {
+      // A miss without a default is `std::nullopt`, which no case produces.
+      d_miss_ordinal = d_index.outcomes().size();
+    }
+  }
+
+  std::size_t ordinal(std::string_view param) const {
+    const std::size_t entry = d_table.find_entry(param);
+    if (entry != FlatTable<Result>::k_NoEntry) {
+      return d_index.entry_ordinal(entry);
+    }
+    if (!d_ranges.empty()) {
+      const std::size_t segment = d_ranges.find_segment(param);
+      if (segment != RangeTable<Result>::k_NoSegment) {
+        return d_index.segment_ordinal(segment);
+      }
+    }
+    return d_miss_ordinal;
+  }
+
+  /// The number of distinct outcomes.
+  std::size_t size() const {
+    const std::size_t num_outcomes = d_index.outcomes().size();
+    return d_miss_ordinal == num_outcomes ? num_outcomes + 1 : num_outcomes;
+  }
+
+  /// The outcome with ordinal `ordinal`.
+  Key key(std::size_t ordinal) const {
+    return ordinal == d_index.outcomes().size()
+               ? d_miss
+               : Key(d_index.outcomes()[ordinal]);
+  }
+
+private:
+  // All of these belong to the switch, which outlives `this`.
+  const FlatTable<Result> &d_table;
+  const RangeTable<Result> &d_ranges;
+  const OutcomeIndex<Result> &d_index;
+  Key d_miss;
+  std::size_t d_miss_ordinal = 0;
+};
+
+// Number of leading rows classified up front to estimate bucket sizes.
+inline constexpr std::size_t k_PartitionSampleSize = 1024;
+
+// Batches smaller than this are always evaluated directly: there are too few
+// rows to amortize building a deduplication table.
+inline constexpr std::size_t k_DeduplicateMinBatch = 1024;
+
+// Number of rows, spread evenly across the batch, inspected to estimate its
+// cardinality.
+inline constexpr std::size_t k_CardinalitySampleSize = 256;
+
+// Deduplicate when at most 1 in this many sampled rows is distinct.
+inline constexpr std::size_t k_DeduplicateMaxDistinctRatio = 8;
+
+// Tables with fewer labels than this stay cached well enough that probing
+// them at random beats merging. Merging also builds, on first use, a sorted
+// table holding its own copy of every label and result, roughly as large as
+// the flat table, which the switch then keeps for as long as it lives; this
+// threshold keeps that cost to switches large enough to gain from it.
+inline constexpr std::size_t k_MergeJoinMinTableSize = std::size_t{1} << 16;
+
+// Merge when the batch has at least one row per this many labels, so that
+// consecutive rows land a short gallop apart in the sorted table.
+inline constexpr std::size_t k_MergeJoinMaxLabelsPerRow = 64;
+
+// Whether an evenly spaced sample of `in` is in ascending order.
+template <StringBatch Range>
+bool sample_is_sorted(const Range &in) {
+  const std::size_t size = std::ranges::size(in);
+  const std::size_t sample_size = std::min(size, k_CardinalitySampleSize);
+  for (std::size_t idx = 1; idx < sample_size; ++idx) {
+    if (std::string_view(in[idx * size / sample_size]) <
+        std::string_view(in[(idx - 1) * size / sample_size])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Decide how to evaluate `in` against a switch with `table_size` labels.
+//
+// Sorted batches that are dense relative to a large table are merged with
+// it. Otherwise, estimate the number of distinct strings in `in` from an
+// evenly spaced sample, and decide whether deduplicating the batch is worth
+// it.
+template <StringBatch Range>
+BatchStrategy choose_batch_strategy(const Range &in, std::size_t table_size) {
+  const std::size_t size = std::ranges::size(in);
+  if (table_size >= k_MergeJoinMinTableSize &&
+      size * k_MergeJoinMaxLabelsPerRow >= table_size &&
+      sample_is_sorted(in)) {
+    return BatchStrategy::k_MergeJoin;
+  }
+  if (size < k_DeduplicateMinBatch) {
+    return BatchStrategy::k_Direct;
+  }
+  std::unordered_set<std::string_view> distinct;
+  distinct.reserve(k_CardinalitySampleSize);
+  for (std::size_t idx = 0; idx != k_CardinalitySampleSize; ++idx) {
+    distinct.insert(std::string_view(in[idx * size / k_CardinalitySampleSize]));
+  }
+  return distinct.size() * k_DeduplicateMaxDistinctRatio <=
+                 k_CardinalitySampleSize
+             ? BatchStrategy::k_Deduplicate
+             : BatchStrategy::k_Direct;
+}
+
+// Evaluate `in` against `sw` by walking the switch's sorted labels from front
+// to back. A row that sorts before the previous one restarts the walk from
+// the first label, so unsorted batches are still evaluated correctly, only
+// more slowly.
+template <StringBatch Range, LateBoundSwitch Switch>
+void merge_join_batch(const Range &in,
+                      const Switch &sw,
+                      std::span<typename Switch::EffectiveResultType> out) {
+  using Outcome = typename Switch::EffectiveResultType;
+
+  const auto &table = SwitchAccess::sorted_table(sw);
+  const std::size_t size = std::ranges::size(in);
+  std::size_t cursor = 0;
+  std::string_view previous;
+  for (std::size_t idx = 0; idx != size; ++idx) {
+    const std::string_view param(in[idx]);
+    if (param < previous) {
+      cursor = 0;
+    }
+    previous = param;
+    cursor = table.lower_bound_from(cursor, param);
+    out[idx] = cursor != table.size() && table.label(cursor) == param
+                   ? Outcome(lookup_result(table.result(cursor)))
+                   : SwitchAccess::fallback(sw, param);
+  }
+}
+
+// An insert-only set of the distinct strings seen in a batch, each tagged with
+// the outcome the switch produced for it.
+//
+// Rows are first matched by identity (same pointer and length), which catches
+// batches of views into an interned dictionary without touching the string
+// bytes. Rows that miss the identity cache fall back to matching on content.
+template <class Key>
+class DistinctOutcomes {
+public:
+  explicit DistinctOutcomes(std::size_t expected_distinct)
+      : d_slots(std::bit_ceil(std::max<std::size_t>(expected_distinct, 8) * 2)),
+        d_identity(d_slots.size()) {}
+
+  // The number of distinct strings seen so far.
+  std::size_t size() const { return d_outcomes.size(); }
+
+  // The outcome for `param`, computing it with `sw` if `param` was not seen
+  // before.
+  template <class Switch>
+  const Key &resolve(std::string_view param, const Switch &sw) {
+    const std::size_t identity_pos = identity_hash(param) & mask();
+    const Identity &cached = d_identity[identity_pos];
+    if (cached.data == param.data() && cached.size == param.size() &&
+        cached.data != nullptr) {
+      return d_outcomes[cached.outcome];
+    }
+
+    const std::size_t hash = std::hash<std::string_view>{}(param);
+    std::size_t pos = hash & mask();
+    while (d_slots[pos].outcome != k_EmptySlot) {
+      const Slot &slot = d_slots[pos];
+      if (slot.hash == hash && slot.value == param) {
+        d_identity[identity_pos] = {param.data(), param.size(), slot.outcome};
+        return d_outcomes[slot.outcome];
+      }
+      pos = (pos + 1) & mask();
+    }
+
+    const auto outcome = static_cast<std::uint32_t>(d_outcomes.size());
+    d_outcomes.push_back(sw.evaluate(param));
+    d_slots[pos] = {param, hash, outcome};
+    d_identity[identity_pos] = {param.data(), param.size(), outcome};
+    if (d_outcomes.size() * 2 > d_slots.size()) {
+      grow();
+    }
+    return d_outcomes.back();
+  }
+
+private:
+  static constexpr std::uint32_t k_EmptySlot = UINT32_MAX;
+
+  struct Slot {
+    std::string_view value;
+    std::size_t hash = 0;
+    std::uint32_t outcome = k_EmptySlot;
+  };
+
+  struct Identity {
+    const char *data = nullptr;
+    std::size_t size = 0;
+    std::uint32_t outcome = 0;
+  };
+
+  static std::size_t identity_hash(std::string_view param) {
+    const auto address = reinterpret_cast<std::uintptr_t>(param.data());
+    return ((address ^ (param.size() << 48)) * 0x9E3779B97F4A7C15ull) >> 17;
+  }
+
+  std::size_t mask() const { return d_slots.size() - 1; }
+
+  void grow() {
+    std::vector<Slot> slots(d_slots.size() * 2);
+    const std::size_t new_mask = slots.size() - 1;
+    for (const Slot &slot : d_slots) {
+      if (slot.outcome != k_EmptySlot) {
+        std::size_t pos = slot.hash & new_mask;
+        while (slots[pos].outcome != k_EmptySlot) {
+          pos = (pos + 1) & new_mask;
+        }
+        slots[pos] = slot;
+      }
+    }
+    d_slots = std::move(slots);
+    // Identity entries keep pointing at valid outcomes; only their placement
+    // depends on the table size, so start the cache over.
+    d_identity.assign(d_slots.size(), Identity{});
+  }
+
+  std::vector<Slot> d_slots;
+  std::vector<Identity> d_identity;
+  std::vector<Key> d_outcomes;
+};
+
+} // namespace detail
+
+/// Evaluate `sw` against every row of `in`, writing the outcome for `in[idx]`
+/// to `out[idx]`. `out` must be at least as large as `in`.
+///
+/// With `BatchStrategy::k_Auto` the batch's cardinality is estimated from a
+/// small sample: batches made of few distinct strings are deduplicated, so
+/// the switch is consulted once per distinct string, while high-cardinality
+/// batches are looked up directly, several rows at a time. A deduplicating
+/// pass that turns out to see many more distinct strings than the sample
+/// suggested falls back to direct lookups for the rest of the batch.
+///
+/// A batch that is sorted in ascending order (for example, keys streaming out
+/// of a merge of sorted runs) can be merge-joined with the switch's labels
+/// instead: they are kept sorted in one array, and each row gallops forwards
+/// from where the previous one stopped, so the labels are read front to back
+/// rather than probed at random. `k_Auto` picks this when the switch has many
+/// labels, the batch has at least one row per 64 labels, and a sample of the
+/// batch is sorted. Unsorted batches are still
+/// evaluated correctly by `k_MergeJoin`, but slowly.
+template <detail::StringBatch Range, detail::LateBoundSwitch Switch>
+void evaluate_batch(const Range &in,
+                    const Switch &sw,
+                    std::span<typename Switch::EffectiveResultType> out,
+                    BatchStrategy strategy = BatchStrategy::k_Auto) {
+  using Key = typename Switch::EffectiveResultType;
+
+  const std::size_t size = std::ranges::size(in);
+  if (strategy == BatchStrategy::k_Auto) {
+    strategy =
+        detail::choose_batch_strategy(in, detail::SwitchAccess::num_cases(sw));
+  }
+  if (strategy == BatchStrategy::k_MergeJoin) {
+    detail::merge_join_batch(in, sw, out);
+    return;
+  }
+
+  std::size_t idx = 0;
+  if (strategy == BatchStrategy::k_Deduplicate) {
+    const std::size_t bailout =
+        std::max(size / detail::k_DeduplicateMaxDistinctRatio,
+                 detail::k_CardinalitySampleSize);
+    detail::DistinctOutcomes<Key> distinct(
+        size / detail::k_CardinalitySampleSize);
+    for (; idx != size; ++idx) {
+      out[idx] = distinct.resolve(std::string_view(in[idx]), sw);
+      if (distinct.size() > bailout) {
+        ++idx;
+        break;
+      }
+    }
+  }
+  // Look the remaining rows up a group at a time in the switch's frozen
+  // table, which hashes short rows side by side in vector registers and
+  // prefetches their slots before probing.
+  const auto &table = detail::SwitchAccess::flat_table(sw);
+  std::string_view keys[detail::k_HashLanes];
+  const typename Switch::ResultType *found[detail::k_HashLanes];
+  while (idx != size) {
+    const std::size_t count = std::min(size - idx, detail::k_HashLanes);
+    for (std::size_t lane = 0; lane != count; ++lane) {
+      keys[lane] = std::string_view(in[idx + lane]);
+    }
+    table.find_group(keys, count, found);
+    for (std::size_t lane = 0; lane != count; ++lane, ++idx) {
+      out[idx] = found[lane] != nullptr
+                     ? Key(detail::lookup_result(*found[lane]))
+                     : detail::SwitchAccess::fallback(sw, keys[lane]);
+    }
+  }
+}
+
+/// Evaluate `sw` against every row of `in`, returning the outcome of each row
+/// in order. See the overload taking an output span for details.
+template <detail::StringBatch Range, detail::LateBoundSwitch Switch>
+std::vector<typename Switch::EffectiveResultType>
+evaluate_batch(const Range &in,
+               const Switch &sw,
+               BatchStrategy strategy = BatchStrategy::k_Auto) {
+  std::vector<typename Switch::EffectiveResultType> out(
+      std::ranges::size(in), detail::SwitchAccess::on_miss(sw));
+  evaluate_batch(in, sw, std::span(out), strategy);
+  return out;
+}
+
+/// Group the positions of `in` by the outcome `sw` produces for them.
+///
+/// Every distinct outcome of `sw` (including the outcome of a miss) gets a
+/// bucket, even if no row classified to it. The input is read once: a leading
+/// sample is used to reserve each bucket in proportion to its share of the
+/// batch, so skewed batches don't pay for repeated reallocation.
+template <detail::StringBatch Range, detail::LateBoundSwitch Switch>
+std::vector<PartitionBucket<typename Switch::EffectiveResultType>>
+partition(const Range &in, const Switch &sw) {
+  using Key = typename Switch::EffectiveResultType;
+
+  detail::OutcomeOrdinals<Switch> ordinals(sw);
+  const std::size_t size = std::ranges::size(in);
+  const std::size_t sample_size = std::min(size, detail::k_PartitionSampleSize);
+
+  std::vector<std::size_t> sample(sample_size);
+  std::vector<std::size_t> sample_counts(ordinals.size());
+  for (std::size_t idx = 0; idx != sample_size; ++idx) {
+    sample[idx] = ordinals.ordinal(std::string_view(in[idx]));
+    ++sample_counts[sample[idx]];
+  }
+
+  std::vector<PartitionBucket<Key>> buckets;
+  buckets.reserve(ordinals.size());
+  for (std::size_t ord = 0; ord != ordinals.size(); ++ord) {
+    buckets.push_back({ordinals.key(ord), {}});
+    if (sample_size != 0) {
+      // Over-reserve slightly so that sampling noise rarely forces a regrow.
+      const std::size_t expected = sample_counts[ord] * size / sample_size;
+      buckets.back().indices.reserve(expected + expected / 8);
+    }
+  }
+
+  for (std::size_t idx = 0; idx != sample_size; ++idx) {
+    buckets[sample[idx]].indices.push_back(idx);
+  }
+  for (std::size_t idx = sample_size; idx != size; ++idx) {
+    buckets[ordinals.ordinal(std::string_view(in[idx]))].indices.push_back(idx);
+  }
+  return buckets;
+}
+
+/// Count how many rows of `in` produce each outcome of `sw`, without
+/// materializing a per-row result.
+///
+/// With `num_threads > 1` the batch is split into contiguous chunks, each
+/// counted by its own thread into thread-local counters that are merged once
+/// at the end.
+template <detail::StringBatch Range, detail::LateBoundSwitch Switch>
+std::vector<HistogramBin<typename Switch::EffectiveResultType>>
+histogram(const Range &in, const Switch &sw, std::size_t num_threads = 1) {
+  using Key = typename Switch::EffectiveResultType;
+
+  const detail::OutcomeOrdinals<Switch> ordinals(sw);
+  const std::size_t size = std::ranges::size(in);
+  const std::size_t num_keys = ordinals.size();
+
+  auto count_chunk = [&](std::size_t begin, std::size_t end,
+                         std::vector<std::size_t> &counts) {
+    std::vector<std::size_t> local(num_keys);
+    for (std::size_t idx = begin; idx != end; ++idx) {
+      ++local[ordinals.ordinal(std::string_view(in[idx]))];
+    }
+    counts = std::move(local);
+  };
+
+  num_threads =
+      std::clamp<std::size_t>(num_threads, 1, std::max<std::size_t>(size, 1));
+  std::vector<std::vector<std::size_t>> partials(num_threads);
+  if (num_threads == 1) {
+    count_chunk(0, size, partials[0]);
+  } else {
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads);
+    for (std::size_t t = 0; t != num_threads; ++t) {
+      workers.emplace_back(count_chunk,
+                           size * t / num_threads,
+                           size * (t + 1) / num_threads,
+                           std::ref(partials[t]));
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  std::vector<HistogramBin<Key>> bins;
+  bins.reserve(num_keys);
+  for (std::size_t ord = 0; ord != num_keys; ++ord) {
+    std::size_t count = 0;
+    for (const auto &partial : partials) {
+      count += partial[ord];
+    }
+    bins.push_back({ordinals.key(ord), count});
+  }
+  return bins;
+}
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_BATCH_H
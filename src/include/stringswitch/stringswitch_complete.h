@@ -0,0 +1,157 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_COMPLETE_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_COMPLETE_H
+
+#include "stringswitch_extras.h"
+#include "stringswitch_impl.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stringswitch {
+
+namespace detail {
+
+/// Answers top-k prefix completion queries over a fixed set of weighted
+/// labels.
+///
+/// The labels are sorted, so the ones starting with a prefix form one range
+/// found by binary search. A sparse table holds the position of the heaviest
+/// label in every range of power-of-two length, so the heaviest label of any
+/// range takes two lookups. The k heaviest are then drawn from a small heap
+/// of ranges: popping the heaviest label of a range splits the range into
+/// the parts left and right of it. A query costs O(log n + k log k)
+/// regardless of how many labels match.
+template <class Result>
+class CompletionIndex {
+public:
+  struct Entry {
+    std::string label;
+    Result result;
+    std::uint64_t weight;
+  };
+
+  explicit CompletionIndex(std::vector<Entry> entries)
+      : d_entries(std::move(entries)) {
+    std::sort(d_entries.begin(), d_entries.end(), [](auto &lhs, auto &rhs) {
+      return lhs.label < rhs.label;
+    });
+    const std::size_t size = d_entries.size();
+    d_heaviest.emplace_back(size);
+    for (std::size_t idx = 0; idx != size; ++idx) {
+      d_heaviest[0][idx] = static_cast<std::uint32_t>(idx);
+    }
+    for (std::size_t level = 1; (std::size_t{1} << level) <= size; ++level) {
+      const std::size_t half = std::size_t{1} << (level - 1);
+      const std::vector<std::uint32_t> &below = d_heaviest.back();
+      std::vector<std::uint32_t> above(size - 2 * half + 1);
+      for (std::size_t idx = 0; idx != above.size(); ++idx) {
+        above[idx] = heavier(below[idx], below[idx + half]);
+      }
+      d_heaviest.push_back(std::move(above));
+    }
+  }
+
+  /// The (at most) `k` heaviest entries whose label starts with `prefix`,
+  /// heaviest first. Equal weights are ordered by label.
+  std::vector<Completion<Result>> complete(std::string_view prefix,
+                                           std::size_t k) const {
+    auto first = std::lower_bound(
+        d_entries.begin(), d_entries.end(), prefix, [](auto &entry, auto key) {
+          return std::string_view(entry.label) < key;
+        });
+    auto last = std::partition_point(first, d_entries.end(), [&](auto &entry) {
+      return std::string_view(entry.label).starts_with(prefix);
+    });
+
+    std::vector<Completion<Result>> completions;
+    if (first == last || k == 0) {
+      return completions;
+    }
+    completions.reserve(std::min<std::size_t>(k, last - first));
+
+    struct Range {
+      std::uint32_t heaviest;
+      std::uint32_t lo;
+      std::uint32_t hi;
+    };
+    auto lighter = [this](const Range &lhs, const Range &rhs) {
+      return heavier(lhs.heaviest, rhs.heaviest) == rhs.heaviest;
+    };
+    std::priority_queue<Range, std::vector<Range>, decltype(lighter)> ranges(
+        lighter);
+    auto push = [&](std::uint32_t lo, std::uint32_t hi) {
+      if (lo != hi) {
+        ranges.push({heaviest_in(lo, hi), lo, hi});
+      }
+    };
+    push(static_cast<std::uint32_t>(first - d_entries.begin()),
+         static_cast<std::uint32_t>(last - d_entries.begin()));
+    while (!ranges.empty() && completions.size() != k) {
+      const Range range = ranges.top();
+      ranges.pop();
+      const Entry &entry = d_entries[range.heaviest];
+      completions.push_back({entry.label, entry.result, entry.weight});
+      push(range.lo, range.heaviest);
+      push(range.heaviest + 1, range.hi);
+    }
+    return completions;
+  }
+
+private:
+  // Of two entries, the one with the greater weight, or the smaller label if
+  // the weights are equal.
+  std::uint32_t heavier(std::uint32_t lhs, std::uint32_t rhs) const {
+    const std::uint64_t lhs_weight = d_entries[lhs].weight;
+    const std::uint64_t rhs_weight = d_entries[rhs].weight;
+    if (lhs_weight != rhs_weight) {
+      return lhs_weight > rhs_weight ? lhs : rhs;
+    }
+    return std::min(lhs, rhs);
+  }
+
+  // The heaviest entry in `d_entries[lo, hi)`, which must not be empty.
+  std::uint32_t heaviest_in(std::uint32_t lo, std::uint32_t hi) const {
+    const auto level = static_cast<std::size_t>(std::bit_width(hi - lo) - 1);
+    return heavier(d_heaviest[level][lo],
+                   d_heaviest[level][hi - (std::uint32_t{1} << level)]);
+  }
+
+  // Sorted by label.
+  std::vector<Entry> d_entries;
+  // `d_heaviest[level][idx]` is the heaviest entry in
+  // `d_entries[idx, idx + 2^level)`.
+  std::vector<std::vector<std::uint32_t>> d_heaviest;
+};
+
+// `sw.complete(prefix, k)`, indexing the labels of `sw` and their weights on
+// the first call.
+template <class Switch>
+std::vector<Completion<typename Switch::ResultType>>
+complete_cases(const Switch &sw, std::string_view prefix, std::size_t k) {
+  using Index = CompletionIndex<typename Switch::ResultType>;
+  const auto &extras = SwitchAccess::extras(sw);
+  const Index &index = extras.completions.get([&] {
+    std::vector<typename Index::Entry> entries;
+    entries.reserve(SwitchAccess::num_cases(sw));
+    SwitchAccess::for_each_case(sw, [&](std::string_view label,
+                                        const auto &result) {
+      auto weight = extras.weights.find(label);
+      const bool weighted = weight != extras.weights.end();
+      entries.push_back(
+          {std::string(label), result, weighted ? weight->second : 0});
+    });
+    return Index(std::move(entries));
+  });
+  return index.complete(prefix, k);
+}
+
+} // namespace detail
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_COMPLETE_H
@@ -0,0 +1,179 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_CPU_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_CPU_H
+
+#include "stringswitch_hash.h"
+#include "stringswitch_kernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <string_view>
+
+namespace stringswitch {
+
+/// The instruction sets the library has specialized kernels for, in
+/// increasing order of capability.
+enum class Isa {
+  k_Scalar,
+  k_Sse2,
+  k_Avx2,
+  /// AVX-512 F and BW.
+  k_Avx512,
+};
+
+namespace detail {
+
+/// The library's ISA-specific building blocks, see stringswitch_kernels.h.
+struct Kernels {
+  Isa isa;
+  void (*hash_short_lanes)(HashLanes &lanes);
+  ProbeMasks (*probe_group)(const HashSlot *slots, std::uint32_t hash);
+  std::size_t (*count_below)(const std::uint64_t *values, std::uint64_t key);
+  bool (*equal_bytes)(const char *lhs, const char *rhs, std::size_t size);
+  std::size_t (*find_byte)(const char *data, std::size_t size, char byte);
+  std::size_t (*find_non_ascii)(const char *data, std::size_t size);
+};
+
+inline constexpr Kernels k_ScalarKernels = {Isa::k_Scalar,
+                                            &hash_short_lanes_scalar,
+                                            &probe_group_scalar,
+                                            &count_below_scalar,
+                                            &equal_bytes_scalar,
+                                            &find_byte_scalar,
+                                            &find_non_ascii_scalar};
+
+#if STRINGSWITCH_X86_KERNELS
+// SSE2 has neither a 32-bit multiply nor a 64-bit compare, so it shares the
+// scalar lane hash and counting.
+inline constexpr Kernels k_Sse2Kernels = {Isa::k_Sse2,
+                                          &hash_short_lanes_scalar,
+                                          &probe_group_sse2,
+                                          &count_below_scalar,
+                                          &equal_bytes_sse2,
+                                          &find_byte_sse2,
+                                          &find_non_ascii_sse2};
+
+inline constexpr Kernels k_Avx2Kernels = {Isa::k_Avx2,
+                                          &hash_short_lanes_avx2,
+                                          &probe_group_avx2,
+                                          &count_below_avx2,
+                                          &equal_bytes_avx2,
+                                          &find_byte_avx2,
+                                          &find_non_ascii_avx2};
+
+inline constexpr Kernels k_Avx512Kernels = {Isa::k_Avx512,
+                                            &hash_short_lanes_avx512,
+                                            &probe_group_avx512,
+                                            &count_below_avx512,
+                                            &equal_bytes_avx512,
+                                            &find_byte_avx512,
+                                            &find_non_ascii_avx512};
+#endif // STRINGSWITCH_X86_KERNELS
+
+inline const Kernels &kernels_for(Isa isa) {
+#if STRINGSWITCH_X86_KERNELS
+  switch (isa) {
+  case Isa::k_Avx512:
+    return k_Avx512Kernels;
+  case Isa::k_Avx2:
+    return k_Avx2Kernels;
+  case Isa::k_Sse2:
+    return k_Sse2Kernels;
+  case Isa::k_Scalar:
+    break;
+  }
+#else
+  static_cast<void>(isa);
+#endif
+  return k_ScalarKernels;
+}
+
+inline Isa detect_isa() {
+#if STRINGSWITCH_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return Isa::k_Avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return Isa::k_Avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return Isa::k_Sse2;
+  }
+#endif
+  return Isa::k_Scalar;
+}
+
+// The ISA named by the `STRINGSWITCH_ISA` environment variable, or `fallback`
+// if it is unset or names no ISA.
+inline Isa isa_from_environment(Isa fallback) {
+  const char *value = std::getenv("STRINGSWITCH_ISA");
+  if (value == nullptr) {
+    return fallback;
+  }
+  const std::string_view name(value);
+  if (name == "scalar") {
+    return Isa::k_Scalar;
+  }
+  if (name == "sse2") {
+    return Isa::k_Sse2;
+  }
+  if (name == "avx2") {
+    return Isa::k_Avx2;
+  }
+  if (name == "avx512") {
+    return Isa::k_Avx512;
+  }
+  return fallback;
+}
+
+// The kernels in use. Null until the first call to `kernels()`.
+inline std::atomic<const Kernels *> g_active_kernels{nullptr};
+
+/// The kernels for the active ISA.
+///
+/// The first call picks the best ISA the CPU supports, lowered to the one
+/// named by the `STRINGSWITCH_ISA` environment variable if that is set.
+inline const Kernels &kernels() {
+  const Kernels *active = g_active_kernels.load(std::memory_order_relaxed);
+  if (active == nullptr) {
+    const Isa detected = detect_isa();
+    active = &kernels_for(std::min(detected, isa_from_environment(detected)));
+    g_active_kernels.store(active, std::memory_order_relaxed);
+  }
+  return *active;
+}
+
+} // namespace detail
+
+/// The most capable ISA the running CPU supports.
+inline Isa detected_isa() {
+  static const Isa isa = detail::detect_isa();
+  return isa;
+}
+
+/// The ISA whose kernels the library currently uses.
+inline Isa active_isa() { return detail::kernels().isa; }
+
+/// Use the kernels for `isa`, or for the most capable supported ISA if the CPU
+/// doesn't support `isa`, and return the ISA actually selected.
+///
+/// This is meant for tests and benchmarks that compare kernels. Lookups
+/// running concurrently may use either set of kernels while the switch
+/// happens, but every set produces the same results.
+inline Isa force_isa(Isa isa) {
+  const detail::Kernels &kernels =
+      detail::kernels_for(std::min(isa, detected_isa()));
+  detail::g_active_kernels.store(&kernels, std::memory_order_relaxed);
+  return kernels.isa;
+}
+
+/// Undo `force_isa`, returning to the ISA selected on first use.
+inline Isa reset_isa() {
+  detail::g_active_kernels.store(nullptr, std::memory_order_relaxed);
+  return active_isa();
+}
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_CPU_H
@@ -0,0 +1,59 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_EXTRAS_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_EXTRAS_H
+
+#include "stringswitch_lazy_index.h"
+#include "stringswitch_ranges.h"
+#include "stringswitch_shared_extras.h"
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace stringswitch::detail {
+
+/// The parts of a stringswitch that most switches never use: ranges, weights,
+/// and the indexes derived from its cases.
+///
+/// The switch only holds them through `SharedExtras`, so this header is only
+/// included by the features that use them: ranges and weights need it, and
+/// the headers of `nearest`, `complete`, and the batch operations include it
+/// along with the index each one builds.
+template <class Result, class Key>
+struct SwitchExtras final : SwitchExtrasBase<Result> {
+  using Weights = std::unordered_map<typename Key::Label,
+                                     std::uint64_t,
+                                     typename Key::Hash,
+                                     typename Key::Equal>;
+
+  SwitchExtras *clone() const override { return new SwitchExtras(*this); }
+
+  void reset_indexes() override {
+    flat_table.reset();
+    sorted_table.reset();
+    suggestions.reset();
+    completions.reset();
+    outcomes.reset();
+  }
+
+  const Result *find_range(std::string_view param) const override {
+    return ranges.empty() ? nullptr : ranges.find(param);
+  }
+
+  RangeTable<Result> ranges;
+  // Weights given to labels of the switch for `complete`; absent means zero.
+  Weights weights;
+  // Frozen copy of the cases for bulk lookups, see `SwitchAccess`.
+  LazyIndex<FlatTable<Result>> flat_table;
+  // Sorted copy of the cases for merging with sorted batches.
+  LazyIndex<SortedTable<Result>> sorted_table;
+  // The labels, indexed for `nearest`.
+  LazyIndex<SuggestionTrie> suggestions;
+  // The labels, indexed for `complete`.
+  LazyIndex<CompletionIndex<Result>> completions;
+  // Ordinals of the results of the cases and ranges, for bulk operations.
+  LazyIndex<OutcomeIndex<Result>> outcomes;
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_EXTRAS_H
@@ -0,0 +1,263 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_FIELDS_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_FIELDS_H
+
+#include "stringswitch_hash.h"
+
+#include <bit>
+#include <bitset>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace stringswitch {
+
+/// The most fields a `FieldBinder` can bind.
+inline constexpr std::size_t k_MaxBoundFields = 64;
+
+/// The fields of a struct that have been bound, by registration order.
+using FieldSet = std::bitset<k_MaxBoundFields>;
+
+/// The outcome of `FieldBinder::bind`.
+enum class BindStatus {
+  /// The value was parsed into its field.
+  k_Bound,
+  /// No field has the given name.
+  k_UnknownField,
+  /// The value could not be parsed; the field may have been partially
+  /// written.
+  k_InvalidValue,
+};
+
+/// Parses the text of a value into strings, `bool`s (`true` or `false`) and
+/// arithmetic types. The parser `FieldBinder` uses for fields that don't name
+/// one.
+struct DefaultFieldParser {
+  template <class Member>
+  bool operator()(std::string_view text, Member &member) const {
+    if constexpr (std::is_same_v<Member, std::string>) {
+      member.assign(text);
+      return true;
+    } else if constexpr (std::is_same_v<Member, bool>) {
+      if (text == "true" || text == "false") {
+        member = text == "true";
+        return true;
+      }
+      return false;
+    } else if constexpr (std::is_arithmetic_v<Member>) {
+      const char *end = text.data() + text.size();
+      auto [ptr, ec] = std::from_chars(text.data(), end, member);
+      return ec == std::errc() && ptr == end;
+    } else {
+      static_assert(sizeof(Member) == 0,
+                    "no default parser for this member type, pass one");
+    }
+  }
+};
+
+/// Maps the field names of a struct `T` to the members they are stored in,
+/// so that a deserializer can hand each key/value pair straight to the code
+/// that parses and writes its member.
+///
+/// ```cpp
+/// struct Endpoint { std::string host; int port = 80; bool tls = false; };
+///
+/// const auto binder = stringswitch::FieldBinder<Endpoint>()
+///                         .required_field("host", &Endpoint::host)
+///                         .field("port", &Endpoint::port)
+///                         .field("tls", &Endpoint::tls);
+///
+/// Endpoint endpoint;
+/// stringswitch::FieldSet seen;
+/// for (auto [key, value] : pairs) {
+///   binder.bind(endpoint, key, value, seen);
+/// }
+/// if (binder.first_missing(seen)) { ... }
+/// ```
+///
+/// Names are looked up through a perfect hash that is rebuilt whenever a
+/// field is added: one hash of the key, a multiply-shift to a slot, and one
+/// comparison with the only name that can be in that slot. Each field then
+/// dispatches through a single indirect call to a function instantiated for
+/// its member and parser.
+template <class T>
+class FieldBinder {
+public:
+  /// Bind `name` to `member`, parsed with `parse(text, member) -> bool`.
+  ///
+  /// `parse` must be trivially copyable and small, like a function pointer
+  /// or a lambda without captures. Throws `std::invalid_argument` if `name`
+  /// is already bound or `k_MaxBoundFields` fields already are.
+  template <class Member, class Parse = DefaultFieldParser>
+  FieldBinder &field(std::string_view name,
+                     Member T::*member,
+                     Parse parse = {}) {
+    add(name, member, parse, false);
+    return *this;
+  }
+
+  /// Like `field`, additionally making the field required, see
+  /// `first_missing`.
+  template <class Member, class Parse = DefaultFieldParser>
+  FieldBinder &required_field(std::string_view name,
+                              Member T::*member,
+                              Parse parse = {}) {
+    add(name, member, parse, true);
+    return *this;
+  }
+
+  std::size_t size() const { return d_fields.size(); }
+
+  /// The registration index of the field called `name`, if there is one.
+  std::optional<std::size_t> find(std::string_view name) const {
+    if (d_fields.empty()) {
+      return std::nullopt;
+    }
+    const std::uint8_t entry = d_slots[slot_of(hash_of(name))];
+    if (entry == 0 || d_fields[entry - 1].name != name) {
+      return std::nullopt;
+    }
+    return entry - 1;
+  }
+
+  /// Parse `value` into the field of `object` called `name`, and mark the
+  /// field in `seen` if that succeeds.
+  BindStatus bind(T &object,
+                  std::string_view name,
+                  std::string_view value,
+                  FieldSet &seen) const {
+    const std::optional<std::size_t> idx = find(name);
+    if (!idx) {
+      return BindStatus::k_UnknownField;
+    }
+    const Field &field = d_fields[*idx];
+    if (!field.write(field.storage, object, value)) {
+      return BindStatus::k_InvalidValue;
+    }
+    seen.set(*idx);
+    return BindStatus::k_Bound;
+  }
+
+  /// The name of the first required field (in registration order) missing
+  /// from `seen`, if any.
+  std::optional<std::string_view> first_missing(const FieldSet &seen) const {
+    const FieldSet missing = d_required & ~seen;
+    if (missing.none()) {
+      return std::nullopt;
+    }
+    for (std::size_t idx = 0; idx != d_fields.size(); ++idx) {
+      if (missing.test(idx)) {
+        return d_fields[idx].name;
+      }
+    }
+    return std::nullopt;
+  }
+
+private:
+  // Room for a member pointer and a parser of the size of a function pointer.
+  static constexpr std::size_t k_StorageSize = 2 * sizeof(void *);
+
+  struct Field {
+    std::string name;
+    std::uint32_t hash;
+    bool (*write)(const unsigned char *storage, T &object,
+                  std::string_view value);
+    alignas(std::max_align_t) unsigned char storage[k_StorageSize];
+  };
+
+  template <class Member, class Parse>
+  struct Binding {
+    Member T::*member;
+    Parse parse;
+  };
+
+  template <class Member, class Parse>
+  static bool write(const unsigned char *storage,
+                    T &object,
+                    std::string_view value) {
+    const auto *binding =
+        std::launder(reinterpret_cast<const Binding<Member, Parse> *>(storage));
+    return binding->parse(value, object.*(binding->member));
+  }
+
+  static std::uint32_t hash_of(std::string_view name) {
+    return detail::hash_bytes(name);
+  }
+
+  std::size_t slot_of(std::uint32_t hash) const {
+    return static_cast<std::uint32_t>(hash * d_multiplier) >> d_shift;
+  }
+
+  template <class Member, class Parse>
+  void add(std::string_view name, Member T::*member, Parse parse,
+           bool required) {
+    using Stored = Binding<Member, Parse>;
+    static_assert(std::is_trivially_copyable_v<Stored> &&
+                      sizeof(Stored) <= k_StorageSize,
+                  "field parsers must be small and trivially copyable");
+    if (find(name)) {
+      throw std::invalid_argument("stringswitch: field bound twice");
+    }
+    if (d_fields.size() == k_MaxBoundFields) {
+      throw std::invalid_argument("stringswitch: too many fields");
+    }
+    Field &field = d_fields.emplace_back();
+    field.name = std::string(name);
+    field.hash = hash_of(name);
+    field.write = &write<Member, Parse>;
+    ::new (field.storage) Stored{member, parse};
+    d_required.set(d_fields.size() - 1, required);
+    try {
+      rebuild();
+    } catch (const std::invalid_argument &) {
+      d_fields.pop_back();
+      d_required.reset(d_fields.size());
+      rebuild();
+      throw;
+    }
+  }
+
+  // Find a multiplier that sends every field to its own slot, growing the
+  // table if a few attempts fail. Only names with equal hashes exhaust this.
+  void rebuild() {
+    std::uint32_t candidate = 0x9E3779B9u;
+    const auto min_bits =
+        static_cast<unsigned>(std::bit_width(d_fields.size()));
+    for (unsigned bits = min_bits; bits != min_bits + 8; ++bits) {
+      for (int attempt = 0; attempt != 64; ++attempt) {
+        // Odd multipliers from a Weyl sequence.
+        candidate += 0x6A09E667u;
+        d_multiplier = candidate | 1;
+        d_shift = 32 - bits;
+        d_slots.assign(std::size_t{1} << bits, 0);
+        bool collided = false;
+        for (std::size_t idx = 0; idx != d_fields.size() && !collided; ++idx) {
+          std::uint8_t &slot = d_slots[slot_of(d_fields[idx].hash)];
+          collided = slot != 0;
+          slot = static_cast<std::uint8_t>(idx + 1);
+        }
+        if (!collided) {
+          return;
+        }
+      }
+    }
+    throw std::invalid_argument("stringswitch: field names collide");
+  }
+
+  std::vector<Field> d_fields;
+  FieldSet d_required;
+  // One past the index of the field hashing to each slot; zero if none.
+  std::vector<std::uint8_t> d_slots;
+  std::uint32_t d_multiplier = 1;
+  unsigned d_shift = 31;
+};
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_FIELDS_H
@@ -0,0 +1,127 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_FLAT_TABLE_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_FLAT_TABLE_H
+
+#include "stringswitch_cpu.h"
+#include "stringswitch_hash.h"
+#include "stringswitch_kernels.h"
+#include "stringswitch_probe_table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stringswitch::detail {
+
+/// An immutable open-addressing table from labels to results, used as the
+/// frozen representation of a stringswitch's cases.
+///
+/// The slots are a `ProbeTable`, so the label is only compared once the full
+/// hash matches. Each entry keeps the `Fingerprint` of its label next to its
+/// size: labels of up to 16 bytes are verified from those alone, and longer
+/// ones only compare the bytes in between, so a false candidate is rejected
+/// without reading the label's storage.
+///
+/// Hashing, probing and label comparison all go through the kernels of the
+/// active ISA (see stringswitch_cpu.h).
+///
+/// Lookups can be issued one at a time with `find`, or a group at a time with
+/// `find_group`, which hashes short keys side by side and prefetches every
+/// slot before probing any of them.
+template <class Result>
+class FlatTable {
+public:
+  /// Sentinel entry returned by `find_entry` for keys that aren't labels.
+  static constexpr std::size_t k_NoEntry = SIZE_MAX;
+
+  /// Create a table with room for `capacity` labels without rehashing.
+  explicit FlatTable(std::size_t capacity) : d_slots(capacity) {
+    d_entries.reserve(capacity);
+  }
+
+  /// Add `label`, which must not already be present.
+  void insert(std::string_view label, Result result) {
+    d_entries.push_back(
+        {Fingerprint::of(label), std::string(label), std::move(result)});
+    d_slots.insert(hash_bytes(label),
+                   static_cast<std::uint32_t>(d_entries.size()));
+  }
+
+  std::size_t size() const { return d_entries.size(); }
+
+  /// The result associated with `key`, or `nullptr` if there is none.
+  const Result *find(std::string_view key) const {
+    const std::uint32_t found = probe(key, hash_bytes(key));
+    return found != 0 ? &d_entries[found - 1].result : nullptr;
+  }
+
+  /// The position of `key` in insertion order, or `k_NoEntry` if it is not a
+  /// label.
+  std::size_t find_entry(std::string_view key) const {
+    const std::uint32_t found = probe(key, hash_bytes(key));
+    return found != 0 ? found - 1 : k_NoEntry;
+  }
+
+  /// The result of the label inserted at position `entry`.
+  const Result &result(std::size_t entry) const {
+    return d_entries[entry].result;
+  }
+
+  /// Look up `keys[0, count)`, storing the result of `keys[idx]` (or
+  /// `nullptr`) in `out[idx]`. `count` must not exceed `k_HashLanes`.
+  void find_group(const std::string_view *keys,
+                  std::size_t count,
+                  const Result **out) const {
+    HashLanes lanes;
+    bool any_short = false;
+    for (std::size_t idx = 0; idx != k_HashLanes; ++idx) {
+      const bool is_short =
+          idx < count && keys[idx].size() <= k_ShortKeySize;
+      lanes.load(idx, is_short ? keys[idx] : std::string_view());
+      any_short |= is_short;
+    }
+    if (any_short) {
+      kernels().hash_short_lanes(lanes);
+    }
+    for (std::size_t idx = 0; idx != count; ++idx) {
+      if (keys[idx].size() > k_ShortKeySize) {
+        lanes.hashes[idx] = hash_bytes(keys[idx]);
+      }
+      d_slots.prefetch(lanes.hashes[idx]);
+    }
+    for (std::size_t idx = 0; idx != count; ++idx) {
+      const std::uint32_t found = probe(keys[idx], lanes.hashes[idx]);
+      out[idx] = found != 0 ? &d_entries[found - 1].result : nullptr;
+    }
+  }
+
+private:
+  struct Entry {
+    Fingerprint fingerprint;
+    std::string label;
+    Result result;
+  };
+
+  // The entry number of `key`, counting from 1, or zero if there is none.
+  std::uint32_t probe(std::string_view key, std::uint32_t hash) const {
+    const Kernels &active = kernels();
+    const Fingerprint print = Fingerprint::of(key);
+    return d_slots.find(hash, active, [&](std::uint32_t entry) {
+      const Entry &candidate = d_entries[entry - 1];
+      return label_equals(candidate.label.data(),
+                          candidate.label.size(),
+                          candidate.fingerprint,
+                          key,
+                          print,
+                          active);
+    });
+  }
+
+  ProbeTable d_slots;
+  std::vector<Entry> d_entries;
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_FLAT_TABLE_H
@@ -0,0 +1,160 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_HASH_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_HASH_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace stringswitch::detail {
+
+// The string hash used by the library's own tables.
+//
+// Keys of up to 16 bytes are hashed from four 32-bit words, assembled with
+// (possibly overlapping) loads that never read outside the key. Each word goes
+// through a multiply/xorshift round that only uses 32-bit lane arithmetic, so
+// the same hash can be computed for a group of keys side by side in vector
+// registers (see `hash_short_lanes_*` in stringswitch_kernels.h). Longer keys
+// are hashed in 16-byte blocks with the same round.
+
+inline constexpr std::uint32_t k_HashSeed = 0x9E3779B9u;
+inline constexpr std::uint32_t k_HashLengthMul = 0x01000193u;
+inline constexpr std::uint32_t k_HashWordMul[4] = {
+    0x85EBCA6Bu, 0xC2B2AE35u, 0x27D4EB2Fu, 0x165667B1u};
+inline constexpr std::uint32_t k_HashFinalMul = 0x7FEB352Du;
+
+/// Keys up to this many bytes are hashed by `hash_short`.
+inline constexpr std::size_t k_ShortKeySize = 16;
+
+inline std::uint32_t load_u32(const char *data) {
+  std::uint32_t word;
+  std::memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+inline std::uint64_t load_u64(const char *data) {
+  std::uint64_t word;
+  std::memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+/// The four words `hash_short` consumes for a key of at most 16 bytes.
+struct ShortKeyWords {
+  std::uint32_t words[4];
+};
+
+inline ShortKeyWords load_short_key(const char *data, std::size_t size) {
+  std::uint64_t lo = 0;
+  std::uint64_t hi = 0;
+  if (size >= 8) {
+    lo = load_u64(data);
+    hi = load_u64(data + size - 8);
+  } else if (size >= 4) {
+    lo = load_u32(data) |
+         (static_cast<std::uint64_t>(load_u32(data + size - 4)) << 32);
+  } else if (size > 0) {
+    lo = static_cast<unsigned char>(data[0]) |
+         (static_cast<unsigned char>(data[size / 2]) << 8) |
+         (static_cast<unsigned char>(data[size - 1]) << 16);
+  }
+  return {{static_cast<std::uint32_t>(lo),
+           static_cast<std::uint32_t>(lo >> 32),
+           static_cast<std::uint32_t>(hi),
+           static_cast<std::uint32_t>(hi >> 32)}};
+}
+
+inline std::uint32_t hash_seed(std::size_t size) {
+  return k_HashSeed ^ (static_cast<std::uint32_t>(size) * k_HashLengthMul);
+}
+
+inline std::uint32_t hash_round(std::uint32_t hash,
+                                std::uint32_t word,
+                                std::uint32_t mul) {
+  hash = (hash ^ word) * mul;
+  return hash ^ (hash >> 15);
+}
+
+inline std::uint32_t hash_finalize(std::uint32_t hash) {
+  hash ^= hash >> 16;
+  hash *= k_HashFinalMul;
+  return hash ^ (hash >> 15);
+}
+
+inline std::uint32_t hash_short(const ShortKeyWords &key, std::size_t size) {
+  std::uint32_t hash = hash_seed(size);
+  for (int idx = 0; idx != 4; ++idx) {
+    hash = hash_round(hash, key.words[idx], k_HashWordMul[idx]);
+  }
+  return hash_finalize(hash);
+}
+
+/// Hash `key` with the library's table hash.
+inline std::uint32_t hash_bytes(std::string_view key) {
+  if (key.size() <= k_ShortKeySize) {
+    return hash_short(load_short_key(key.data(), key.size()), key.size());
+  }
+  std::uint32_t hash = hash_seed(key.size());
+  auto mix_block = [&hash](const char *block) {
+    for (int idx = 0; idx != 4; ++idx) {
+      hash = hash_round(hash, load_u32(block + 4 * idx), k_HashWordMul[idx]);
+    }
+  };
+  std::size_t offset = 0;
+  for (; offset + k_ShortKeySize < key.size(); offset += k_ShortKeySize) {
+    mix_block(key.data() + offset);
+  }
+  // The last block overlaps the previous one rather than being padded.
+  mix_block(key.data() + key.size() - k_ShortKeySize);
+  return hash_finalize(hash);
+}
+
+/// Hashes a key whose bytes are produced as it is read, such as a key being
+/// normalized or transcoded, without buffering it. The hash only depends on
+/// the bytes, not on how they were split between calls to `add`.
+class StreamingHash {
+public:
+  void add(unsigned char byte) {
+    d_word |= std::uint64_t{byte} << (8 * (d_size % 8));
+    if (++d_size % 8 == 0) {
+      d_hash = round(d_hash, d_word);
+      d_word = 0;
+    }
+  }
+
+  void add(std::string_view bytes) {
+    std::size_t idx = 0;
+    if (std::endian::native == std::endian::little && d_size % 8 == 0) {
+      for (; idx + 8 <= bytes.size(); idx += 8) {
+        d_hash = round(d_hash, load_u64(bytes.data() + idx));
+      }
+      d_size += idx;
+    }
+    for (; idx != bytes.size(); ++idx) {
+      add(static_cast<unsigned char>(bytes[idx]));
+    }
+  }
+
+  std::size_t value() const {
+    std::uint64_t hash = d_hash;
+    if (d_size % 8 != 0) {
+      hash = round(hash, d_word);
+    }
+    return static_cast<std::size_t>(round(hash, d_size));
+  }
+
+private:
+  static std::uint64_t round(std::uint64_t hash, std::uint64_t word) {
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 32);
+  }
+
+  std::uint64_t d_hash = 0;
+  // The bytes added since the last full word, little-endian.
+  std::uint64_t d_word = 0;
+  std::size_t d_size = 0;
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_HASH_H
@@ -1,11 +1,70 @@
 #ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_IMPL_H
 #define INCLUDED_STRINGSWITCH_STRINGSWITCH_IMPL_H
 
+#include "stringswitch_keys.h"
+#include "stringswitch_shared_extras.h"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
+
+// The optional features of a switch are defined in their own headers, which
+// only the code using them includes: stringswitch_extras.h for ranges and
+// weights, stringswitch_suggest.h for `nearest`, stringswitch_complete.h for
+// `complete`, stringswitch_json.h for `evaluate_json_escaped`,
+// stringswitch_lazy.h for `Lazy` results, and stringswitch_batch.h for bulk
+// operations. The switch only declares them, so a translation unit that
+// evaluates plain cases compiles none of them.
+namespace stringswitch {
+
+template <class T>
+class Lazy;
+
+/// A registered label close to a parameter that matched none, see
+/// `StringSwitchImpl::nearest`.
+struct Suggestion {
+  std::string_view label;
+  /// The Levenshtein distance between the label and the parameter.
+  std::size_t distance;
+};
+
+/// A label returned by `StringSwitchImpl::complete`.
+template <class Result>
+struct Completion {
+  std::string_view label;
+  Result result;
+  std::uint64_t weight;
+};
+
+namespace detail {
+
+template <class T>
+inline constexpr bool k_IsLazy = false;
+
+template <class T>
+inline constexpr bool k_IsLazy<Lazy<T>> = true;
+
+// `result` as a lookup hands it out: borrowed for `Lazy` results, so that a
+// hit on a switch shared between threads writes no shared memory.
+template <class T>
+const T &lookup_result(const T &result) {
+  return result;
+}
+
+// Defined in stringswitch_lazy.h.
+template <class T>
+Lazy<T> lookup_result(const Lazy<T> &result);
+
+} // namespace detail
+} // namespace stringswitch
 
 namespace stringswitch::detail {
 
@@ -30,9 +89,131 @@ class ParamBoundTag : public std::bool_constant<state> {};
 template <bool state>
 class DefaultBoundTag : public std::bool_constant<state> {};
 
-template <class Result, class ParamStateTag = void, class ResultStateTag = void>
+// A parameter bound with `StringSwitch::create(param)`, owned like a label.
+// Empty if the key can't own it (see `TranscodingKey::try_own`), in which case
+// it matches no case, as the same parameter would when passed to `evaluate`.
+template <class Key>
+using BoundParam = std::optional<typename Key::Label>;
+
+template <class Key>
+BoundParam<Key> bind_param(const typename Key::Param &param) {
+  if constexpr (requires { Key::try_own(param); }) {
+    return Key::try_own(param);
+  } else {
+    return Key::own(param);
+  }
+}
+
+template <class Result,
+          class ParamStateTag = void,
+          class ResultStateTag = void,
+          class Key = StringKey>
 class StringSwitchImpl;
 
+/// A stringswitch keyed on plain strings, that has its cases set up and takes
+/// its parameter at evaluation time. Its labels match parameters byte for
+/// byte, so they can be copied into other indexes.
+template <class Switch>
+concept LateBoundSwitch = requires(const Switch &sw, std::string_view param) {
+  typename Switch::EffectiveResultType;
+  requires std::same_as<typename Switch::KeyTraits, StringKey>;
+  {
+    sw.evaluate(param)
+  } -> std::same_as<typename Switch::EffectiveResultType>;
+};
+
+/// Grants library components (batch evaluation, derived indexes, ...) read
+/// access to the cases of a terminal stringswitch without widening its public
+/// interface.
+struct SwitchAccess {
+  /// Invoke `visit(label, result)` once for every case registered with `when`.
+  template <class Switch, class Visitor>
+  static void for_each_case(const Switch &sw, Visitor &&visit) {
+    for (const auto &[label, result] : sw.d_mapping) {
+      visit(std::string_view(label), result);
+    }
+  }
+
+  /// The number of cases registered with `when`.
+  template <class Switch>
+  static std::size_t num_cases(const Switch &sw) {
+    return sw.d_mapping.size();
+  }
+
+  /// The ranges, weights, and indexes of `sw`, allocated on first use. See
+  /// stringswitch_extras.h, which callers include.
+  template <class Switch>
+  static const auto &extras(const Switch &sw) {
+    return sw.d_extras.template get<typename Switch::Extras>();
+  }
+
+  /// The cases of `sw` frozen into a `FlatTable`, built on first use.
+  template <class Switch>
+  static const auto &flat_table(const Switch &sw) {
+    return extras(sw).flat_table.get([&sw] {
+      FlatTable<typename Switch::ResultType> table(sw.d_mapping.size());
+      for (const auto &[label, result] : sw.d_mapping) {
+        table.insert(label, result);
+      }
+      return table;
+    });
+  }
+
+  /// The cases of `sw` frozen into a `SortedTable`, built on first use.
+  template <class Switch>
+  static const auto &sorted_table(const Switch &sw) {
+    return extras(sw).sorted_table.get([&sw] {
+      using Table = SortedTable<typename Switch::ResultType>;
+      std::vector<typename Table::Case> cases;
+      cases.reserve(sw.d_mapping.size());
+      for (const auto &[label, result] : sw.d_mapping) {
+        cases.push_back({label, result});
+      }
+      return Table(std::move(cases));
+    });
+  }
+
+  /// Whether `sw` has ranges registered with `when_between` or
+  /// `when_at_least`.
+  template <class Switch>
+  static bool has_ranges(const Switch &sw) {
+    using Extras = typename Switch::Extras;
+    const auto *found = sw.d_extras.find();
+    return found != nullptr &&
+           !static_cast<const Extras &>(*found).ranges.empty();
+  }
+
+  /// The ranges registered with `when_between` and `when_at_least`.
+  template <class Switch>
+  static const auto &ranges(const Switch &sw) {
+    return extras(sw).ranges;
+  }
+
+  /// Ordinals of the results of the cases and ranges of `sw`, built on first
+  /// use.
+  template <class Switch>
+  static const auto &outcome_index(const Switch &sw) {
+    return extras(sw).outcomes.get([&sw] {
+      return OutcomeIndex<typename Switch::ResultType>(flat_table(sw),
+                                                       extras(sw).ranges);
+    });
+  }
+
+  /// The outcome `sw` produces for `param` when it matches none of the cases
+  /// registered with `when`.
+  template <class Switch>
+  static typename Switch::EffectiveResultType fallback(const Switch &sw,
+                                                       std::string_view param) {
+    return sw.fallback(param);
+  }
+
+  /// The outcome `sw` produces for a parameter that matches none of its cases.
+  template <class Switch>
+  static typename Switch::EffectiveResultType on_miss(const Switch &sw) {
+    return sw.miss();
+  }
+};
+
 /// Terminal state, that knows about parameters as well as defaults assocaited
 /// with the stringswitch.
 ///
@@ -43,23 +224,95 @@ class StringSwitchImpl;
 ///
 /// Allows users to set up cases (using `StringSwitchImpl::when`) or defaults
 /// (using `StringSwitchImpl::on_default`).
-template <class Result, bool param_given, bool default_given>
+template <class Result, bool param_given, bool default_given, class Key>
 class StringSwitchImpl<Result, ParamBoundTag<param_given>,
-                       DefaultBoundTag<default_given>> {
+                       DefaultBoundTag<default_given>, Key> {
 public:
-  using Param = std::string;
+  using Param = typename Key::Label;
+  using KeyParam = typename Key::Param;
+  using KeyTraits = Key;
+  using ResultType = Result;
   using EffectiveResultType =
       std::conditional_t<default_given, Result, std::optional<Result>>;
 
   template <bool state>
   using SelfWithDefault = StringSwitchImpl<Result, ParamBoundTag<param_given>,
-                                           DefaultBoundTag<state>>;
+                                           DefaultBoundTag<state>, Key>;
 
   /// Associate the paramter  `label` to the Outcome `result`.
   /// If the parameter used to evaluate the stringswitch matches the label
   /// provided here, `result` will be returned.
-  SelfWithDefault<default_given> &when(std::string_view label, Result result) {
-    this->d_mapping.emplace(std::make_pair(label, result));
+  SelfWithDefault<default_given> &when(const KeyParam &label, Result result) {
+    this->d_mapping.emplace(Key::own(label), result);
+    auto *extras = d_extras.modify_existing();
+    if (extras != nullptr) {
+      extras->reset_indexes();
+    }
+    return *this;
+  }
+
+  /// Associate `label` with the result `factory()`, built the first time a
+  /// lookup that matches `label` calls `get` on it. See `Lazy`.
+  template <class Factory>
+  SelfWithDefault<default_given> &when_lazy(const KeyParam &label,
+                                            Factory factory)
+  requires(k_IsLazy<Result>)
+  {
+    return when(label, Result::deferred(std::move(factory)));
+  }
+
+  /// Like `when`, also giving the label a `weight` that ranks it in
+  /// `complete`. Labels registered without a weight weigh zero.
+  SelfWithDefault<default_given> &
+  when(std::string_view label, Result result, std::uint64_t weight)
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    when(label, std::move(result));
+    return set_weight(label, weight);
+  }
+
+  /// Change the weight of the registered `label`, for example from hit
+  /// statistics. Throws `std::invalid_argument` if `label` has no case.
+  /// Needs stringswitch_extras.h.
+  SelfWithDefault<default_given> &set_weight(std::string_view label,
+                                             std::uint64_t weight)
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    auto it = d_mapping.find(label);
+    if (it == d_mapping.end()) {
+      throw std::invalid_argument("stringswitch: no case for label");
+    }
+    Extras &extras = d_extras.template modify<Extras>();
+    extras.weights.insert_or_assign(it->first, weight);
+    extras.completions.reset();
+    return *this;
+  }
+
+  /// Associate every parameter in the half-open lexicographic range
+  /// `[lower, upper)` to the Outcome `result`.
+  ///
+  /// Cases registered with `when` take precedence over ranges. Ranges may not
+  /// overlap each other; an empty or overlapping range throws
+  /// `std::invalid_argument`. Needs stringswitch_extras.h.
+  SelfWithDefault<default_given> &
+  when_between(std::string_view lower, std::string_view upper, Result result)
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    Extras &extras = this->d_extras.template modify<Extras>();
+    extras.ranges.add(lower, upper, std::move(result));
+    extras.outcomes.reset();
+    return *this;
+  }
+
+  /// Associate every parameter not less than `lower` (lexicographically) to
+  /// the Outcome `result`. See `when_between`.
+  SelfWithDefault<default_given> &when_at_least(std::string_view lower,
+                                                Result result)
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    Extras &extras = this->d_extras.template modify<Extras>();
+    extras.ranges.add(lower, std::nullopt, std::move(result));
+    extras.outcomes.reset();
     return *this;
   }
 
@@ -67,58 +320,152 @@ public:
   SelfWithDefault<true> on_default(Result default_result)
   requires(!default_given)
   {
-    return SelfWithDefault<true>{d_mapping, d_param, default_result};
+    return SelfWithDefault<true>{d_mapping, d_extras, d_param, default_result};
   }
 
   /// Evaluate the stringswitch with the given parameter.
-  EffectiveResultType evaluate(std::string_view param) const
+  EffectiveResultType evaluate(const KeyParam &param) const
   requires(!param_given)
   {
-    return evaluate_impl(std::string(param));
+    return evaluate_impl(param);
+  }
+
+  /// Evaluate the stringswitch with the contents of a JSON string, `raw`, as
+  /// it appears between the quotes in the document, without unescaping it
+  /// first.
+  ///
+  /// Keys without a backslash, the common case, are looked up as is; only
+  /// keys with escapes are decoded, into a stack buffer when they are short.
+  /// A malformed escape never matches a case. Needs stringswitch_json.h.
+  EffectiveResultType evaluate_json_escaped(std::string_view raw) const
+  requires(!param_given && std::is_same_v<Key, StringKey>)
+  {
+    return evaluate_escaped(*this, raw);
   }
 
   /// Evaluate the stringswitch using the parameter provided during creation.
   EffectiveResultType evaluate() const
   requires(param_given)
   {
-    return evaluate_impl(d_param);
+    const Result *result = nullptr;
+    if (d_param) {
+      // `d_param` went through `Key::own` like the labels did, so look it up
+      // as a label: keys that normalize parameters must not normalize it
+      // again.
+      auto it = d_mapping.find(*d_param);
+      result = it != d_mapping.end() ? &it->second
+                                     : find_range(Key::view(*d_param));
+    }
+    // Early-bound switches are usually temporaries, so hand out a copy that
+    // owns its value even for `Lazy` results.
+    if (result != nullptr) {
+      return *result;
+    }
+    if constexpr (default_given) {
+      return d_default_outcome;
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  /// The label registered with `when` that is closest to `param` in
+  /// Levenshtein distance, if one is at most `max_distance` edits away. Meant
+  /// for "did you mean" messages after a miss.
+  ///
+  /// The first call indexes the labels in a trie; the suggested label points
+  /// into that index and stays valid until the cases change. Needs
+  /// stringswitch_suggest.h.
+  std::optional<Suggestion> nearest(std::string_view param,
+                                    std::size_t max_distance) const
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    return nearest_case(*this, param, max_distance);
+  }
+
+  /// The (at most) `k` heaviest labels registered with `when` that start with
+  /// `prefix`, with their results, heaviest first. Labels of equal weight are
+  /// ordered lexicographically.
+  ///
+  /// The first call indexes the labels; a query then costs O(log n + k log k)
+  /// however many labels match. The returned labels point into the index and
+  /// stay valid until the cases or weights change. Needs
+  /// stringswitch_complete.h.
+  std::vector<Completion<Result>> complete(std::string_view prefix,
+                                           std::size_t k) const
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    return complete_cases(*this, prefix, k);
   }
 
 private:
   // Allow a stringswitch with the same parameter state to construct this type.
-  friend class StringSwitchImpl<Result, ParamBoundTag<param_given>>;
+  friend class StringSwitchImpl<Result, ParamBoundTag<param_given>, void,
+                                Key>;
   // Allow classes with type-tag DefaultBoundTag<false> to cosntruct
   // DefaultBoundTag<true>.
   //
   // This is a transition that happens when `.on_default()` is called the first
   // time.
   friend class StringSwitchImpl<Result, ParamBoundTag<param_given>,
-                                DefaultBoundTag<false>>;
+                                DefaultBoundTag<false>, Key>;
+  friend struct SwitchAccess;
 
-  using ParamType = std::string;
-  using ParamStorage = std::conditional_t<param_given, ParamType, Empty>;
+  using ParamType = typename Key::Label;
+  using ParamStorage =
+      std::conditional_t<param_given, BoundParam<Key>, Empty>;
   using OutcomeStorage = std::conditional_t<default_given, Result, Empty>;
-  using MapStorage = std::unordered_map<ParamType, Result>;
+  using MapStorage = std::unordered_map<ParamType, Result,
+                                        typename Key::Hash,
+                                        typename Key::Equal>;
+  using Extras = SwitchExtras<Result, Key>;
+  using ExtrasStorage = SharedExtras<Result>;
 
-  StringSwitchImpl(MapStorage mapping_args, ParamStorage param,
-                   OutcomeStorage outcome)
+  StringSwitchImpl(MapStorage mapping_args, ExtrasStorage extras,
+                   ParamStorage param, OutcomeStorage outcome)
       : d_mapping(mapping_args),
+        d_extras(std::move(extras)),
         d_param(param),
         d_default_outcome(outcome) {}
 
-  EffectiveResultType evaluate_impl(const std::string &param) const {
+  // Results are handed out through `lookup_result`, which borrows `Lazy`
+  // results from the switch instead of sharing ownership.
+  EffectiveResultType evaluate_impl(const KeyParam &param) const {
     auto it = d_mapping.find(param);
     if (it != d_mapping.end()) {
-      return it->second;
+      return lookup_result(it->second);
     }
+    return fallback(param);
+  }
+
+  EffectiveResultType fallback(const KeyParam &param) const {
+    if (const Result *result = find_range(param)) {
+      return lookup_result(*result);
+    }
+    return miss();
+  }
+
+  const Result *find_range(const KeyParam &param) const {
+    if constexpr (std::is_same_v<Key, StringKey>) {
+      const auto *extras = d_extras.find();
+      if (extras != nullptr) {
+        return extras->find_range(param);
+      }
+    }
+    return nullptr;
+  }
+
+  EffectiveResultType miss() const {
     if constexpr (default_given) {
-      return d_default_outcome;
+      return lookup_result(d_default_outcome);
     } else {
       return std::nullopt;
     }
   }
 
   MapStorage d_mapping;
+  // Ranges, weights, and indexes derived from `d_mapping`, allocated when
+  // first needed and shared with copies of the switch until either changes.
+  ExtrasStorage d_extras;
   ParamStorage d_param;
   OutcomeStorage d_default_outcome;
 };
@@ -130,34 +477,71 @@ private:
 ///
 /// Allows users to set up cases (using `StringSwitchImpl::when`) or defaults
 /// (using `StringSwitchImpl::on_default`).
-template <class Result, bool param_given>
-class StringSwitchImpl<Result, ParamBoundTag<param_given>> {
+template <class Result, bool param_given, class Key>
+class StringSwitchImpl<Result, ParamBoundTag<param_given>, void, Key> {
 public:
-  using Param = std::string;
+  using Param = typename Key::Label;
+  using KeyParam = typename Key::Param;
   template <bool default_given>
 
   // Convenience typedef so the return type is somewhat readable
   using StringSwitchWithDefault =
       StringSwitchImpl<Result, ParamBoundTag<param_given>,
-                       DefaultBoundTag<default_given>>;
+                       DefaultBoundTag<default_given>, Key>;
+
+  StringSwitchWithDefault<false> when(const KeyParam &label, Result &&result) {
+    return {{{Key::own(label), std::move(result)}}, {}, d_param, {}};
+  }
+
+  template <class Factory>
+  StringSwitchWithDefault<false> when_lazy(const KeyParam &label,
+                                           Factory factory)
+  requires(k_IsLazy<Result>)
+  {
+    return when(label, Result::deferred(std::move(factory)));
+  }
 
-  StringSwitchWithDefault<false> when(std::string_view label, Result &&result) {
-    return {{{std::string(label), std::move(result)}}, d_param, {}};
+  StringSwitchWithDefault<false>
+  when(std::string_view label, Result &&result, std::uint64_t weight)
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    StringSwitchWithDefault<false> next{{}, {}, d_param, {}};
+    next.when(label, std::move(result), weight);
+    return next;
+  }
+
+  StringSwitchWithDefault<false> when_between(std::string_view lower,
+                                              std::string_view upper,
+                                              Result &&result)
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    StringSwitchWithDefault<false> next{{}, {}, d_param, {}};
+    next.when_between(lower, upper, std::move(result));
+    return next;
+  }
+
+  StringSwitchWithDefault<false> when_at_least(std::string_view lower,
+                                               Result &&result)
+  requires(std::is_same_v<Key, StringKey>)
+  {
+    StringSwitchWithDefault<false> next{{}, {}, d_param, {}};
+    next.when_at_least(lower, std::move(result));
+    return next;
   }
 
   StringSwitchWithDefault<true> on_default(Result &&result) {
-    return {{}, {}, result};
+    return {{}, {}, d_param, result};
   }
 
 private:
   // The default specialization is the entrypoint and is the only way to reach
   // a state with only parameters bound. Declare it as friend so it is able
   // to call our private constructor.
-  friend class StringSwitchImpl<Result>;
+  friend class StringSwitchImpl<Result, void, void, Key>;
 
-  explicit StringSwitchImpl(std::string_view param)
+  explicit StringSwitchImpl(const KeyParam &param)
   requires(param_given)
-      : d_param(param) {}
+      : d_param(bind_param<Key>(param)) {}
 
   StringSwitchImpl()
   requires(!param_given)
@@ -166,7 +550,7 @@ private:
   // TODO:
   // This occupies at least 1 extra byte when no parameter was provided, try to
   // eliminate this storage requirement.
-  std::conditional_t<param_given, Param, Empty> d_param;
+  std::conditional_t<param_given, BoundParam<Key>, Empty> d_param;
 };
 
 /// The default specialization is the entrypoint for `StringSwitch` as a
@@ -175,14 +559,14 @@ private:
 ///
 /// Attributes such as cases, and defaults are allowed on types downstream in
 /// the state-machine.
-template <class Result>
-class StringSwitchImpl<Result> {
+template <class Result, class Key>
+class StringSwitchImpl<Result, void, void, Key> {
 public:
   template <bool param_given>
   using StringSwitchWithParam =
-      StringSwitchImpl<Result, ParamBoundTag<param_given>>;
+      StringSwitchImpl<Result, ParamBoundTag<param_given>, void, Key>;
 
-  static StringSwitchWithParam<true> create(std::string_view param) {
+  static StringSwitchWithParam<true> create(const typename Key::Param &param) {
     return StringSwitchWithParam<true>{param};
   }
 
@@ -191,4 +575,42 @@ public:
 
 } // namespace stringswitch::detail
 
+// Explicit instantiation of the stringswitch engine for a result type, so
+// that translation units using it need not instantiate and compile it again.
+//
+// For a result type `MyEnum`, write `STRINGSWITCH_EXTERN_TEMPLATES(MyEnum);`
+// in a header after including stringswitch.h, and
+// `STRINGSWITCH_INSTANTIATE(MyEnum);` in one source file. This covers
+// switches over `StringKey` in every state that can be evaluated. As it
+// instantiates every member, that source file includes the headers of every
+// feature first; the feature engines themselves are left to the code using
+// them.
+#define STRINGSWITCH_INSTANTIATE_SWITCH(prefix, Result, param, dflt)           \
+  prefix template class ::stringswitch::detail::StringSwitchImpl<              \
+      Result,                                                                  \
+      ::stringswitch::detail::ParamBoundTag<param>,                            \
+      ::stringswitch::detail::DefaultBoundTag<dflt>>
+#define STRINGSWITCH_INSTANTIATIONS(prefix, Result)                            \
+  STRINGSWITCH_INSTANTIATE_SWITCH(prefix, Result, false, false);               \
+  STRINGSWITCH_INSTANTIATE_SWITCH(prefix, Result, false, true);                \
+  STRINGSWITCH_INSTANTIATE_SWITCH(prefix, Result, true, false);                \
+  STRINGSWITCH_INSTANTIATE_SWITCH(prefix, Result, true, true)
+#define STRINGSWITCH_EXTERN_TEMPLATES(Result)                                  \
+  STRINGSWITCH_INSTANTIATIONS(extern, Result)
+#define STRINGSWITCH_INSTANTIATE(Result) STRINGSWITCH_INSTANTIATIONS(, Result)
+
+// The result types instantiated by the `stringswitch_core` library.
+#define STRINGSWITCH_FOR_EACH_PRECOMPILED_RESULT(X)                            \
+  X(int);                                                                      \
+  X(unsigned);                                                                 \
+  X(long);                                                                     \
+  X(unsigned long);                                                            \
+  X(long long);                                                                \
+  X(unsigned long long)
+
+// Defined when linking `stringswitch_core`, which holds these instantiations.
+#ifdef STRINGSWITCH_PRECOMPILED
+STRINGSWITCH_FOR_EACH_PRECOMPILED_RESULT(STRINGSWITCH_EXTERN_TEMPLATES);
+#endif
+
 #endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_IMPL_H
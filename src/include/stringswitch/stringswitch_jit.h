@@ -0,0 +1,591 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_JIT_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_JIT_H
+
+#include "stringswitch_impl.h"
+#include "stringswitch_probe_table.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Define STRINGSWITCH_DISABLE_JIT to always interpret compiled switches.
+#if defined(__x86_64__) && defined(__linux__) &&                               \
+    !defined(STRINGSWITCH_DISABLE_JIT)
+#define STRINGSWITCH_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define STRINGSWITCH_JIT 0
+#endif
+
+namespace stringswitch {
+
+/// How a `CompiledSwitch` runs its perfect hash.
+enum class JitMode {
+  /// Generate native code where supported, and interpret it elsewhere.
+  k_Auto,
+  /// Always interpret the perfect hash.
+  k_Interpret,
+};
+
+namespace detail {
+
+/// A perfect hash over a fixed set of labels: each label hashes to a slot of
+/// its own, so a lookup is one hash followed by one verifying compare.
+///
+/// The top bits of a key's hash pick one of about a quarter as many buckets
+/// as labels, and each bucket has a displacement, found while building, that
+/// sends all of its labels to free slots ("hash and displace"). Keys of up to
+/// `Fingerprint::k_Size` bytes are hashed and verified through their size and
+/// `Fingerprint` alone; longer ones also hash and compare their middle bytes.
+class PerfectHash {
+public:
+  static constexpr std::uint32_t k_Miss = UINT32_MAX;
+
+  /// The multipliers of `hash`.
+  static constexpr std::uint64_t k_Mul[3] = {
+      0x9E3779B97F4A7C15u, 0xC2B2AE3D27D4EB4Fu, 0x165667B19E3779F9u};
+
+  /// The label that hashes to a slot. A free slot is all zeros except for
+  /// `label`, which is `k_Miss`, so it only matches the empty key and then
+  /// reports a miss.
+  struct Slot {
+    Fingerprint print;
+    std::uint32_t size;
+    std::uint32_t label;
+    // For labels longer than `Fingerprint::k_Size`, where the label's bytes
+    // start in `d_bytes`.
+    std::uint32_t offset = 0;
+  };
+
+  /// Build a perfect hash over `labels`, which must be distinct. Throws
+  /// `std::length_error` if there are too many labels or bytes to index with
+  /// 32 bits.
+  explicit PerfectHash(const std::vector<std::string_view> &labels) {
+    if (labels.size() >= k_Miss) {
+      throw std::length_error("stringswitch: too many labels to compile");
+    }
+    std::vector<Slot> keys;
+    keys.reserve(labels.size());
+    for (std::uint32_t idx = 0; idx != labels.size(); ++idx) {
+      const std::string_view label = labels[idx];
+      if (label.size() > UINT32_MAX - d_bytes.size()) {
+        throw std::length_error("stringswitch: labels too long to compile");
+      }
+      Slot &slot = keys.emplace_back(Slot{Fingerprint::of(label),
+                                          static_cast<std::uint32_t>(
+                                              label.size()),
+                                          idx});
+      if (label.size() > Fingerprint::k_Size) {
+        slot.offset = static_cast<std::uint32_t>(d_bytes.size());
+        d_bytes.append(label);
+      }
+    }
+    place(labels, keys);
+  }
+
+  /// The index of the label equal to `key`, or `k_Miss`.
+  std::uint32_t find(std::string_view key) const {
+    const Fingerprint print = Fingerprint::of(key);
+    const Slot &slot = d_slots[position(hash(key, print, d_seed))];
+    if (slot.size != key.size() || !(slot.print == print)) {
+      return k_Miss;
+    }
+    if (key.size() > Fingerprint::k_Size &&
+        std::memcmp(key.data() + 8,
+                    d_bytes.data() + slot.offset + 8,
+                    key.size() - Fingerprint::k_Size) != 0) {
+      return k_Miss;
+    }
+    return slot.label;
+  }
+
+  /// `find` for the `size` bytes at `data` in `table`, which generated code
+  /// tail-calls for keys longer than `Fingerprint::k_Size`.
+  static std::uint32_t
+  find_long(const char *data, std::size_t size, const PerfectHash *table) {
+    return table->find({data, size});
+  }
+
+  /// The hash of `key`, whose fingerprint is `print`. Each word of the key
+  /// (its head, any middle bytes, its tail, and its size) is mixed in after
+  /// folding the high half of the hash so far into the low one, so that
+  /// every byte reaches every bit of the hash.
+  static std::uint64_t
+  hash(std::string_view key, const Fingerprint &print, std::uint64_t seed) {
+    std::uint64_t hash = (print.head ^ seed) * k_Mul[0];
+    if (key.size() > Fingerprint::k_Size) {
+      // The bytes between the head and the tail, the last word overlapping
+      // the one before.
+      const std::size_t last = key.size() - Fingerprint::k_Size;
+      for (std::size_t offset = 8; offset < last; offset += 8) {
+        hash = (hash ^ (hash >> 32) ^ load_u64(key.data() + offset)) * k_Mul[1];
+      }
+      hash = (hash ^ (hash >> 32) ^ load_u64(key.data() + last)) * k_Mul[1];
+    }
+    hash = (hash ^ (hash >> 32) ^ print.tail) * k_Mul[1];
+    hash = (hash ^ (hash >> 32) ^ key.size()) * k_Mul[2];
+    return hash ^ (hash >> 32);
+  }
+
+  /// The slot of the key with `hash`, which is the lower 32 bits of the hash
+  /// plus the bucket's displacement times the upper 32, made odd.
+  std::uint32_t position(std::uint64_t hash) const {
+    return slot_of(hash, d_displacements[hash >> d_shift], d_mask);
+  }
+
+  std::uint64_t seed() const { return d_seed; }
+
+  unsigned shift() const { return d_shift; }
+
+  std::uint32_t mask() const { return d_mask; }
+
+  const std::uint32_t *displacements() const {
+    return d_displacements.data();
+  }
+
+  const Slot *slots() const { return d_slots.data(); }
+
+private:
+  // Give up after this many seeds, doubling the slots every
+  // `k_AttemptsPerSize`. In practice the first seed almost always works.
+  static constexpr unsigned k_MaxAttempts = 32;
+  static constexpr unsigned k_AttemptsPerSize = 4;
+
+  static std::uint32_t
+  slot_of(std::uint64_t hash, std::uint32_t displacement, std::uint32_t mask) {
+    const auto step = static_cast<std::uint32_t>(hash >> 32) | 1;
+    return (static_cast<std::uint32_t>(hash) + displacement * step) & mask;
+  }
+
+  // Find a seed and displacements under which `labels` have distinct slots,
+  // and fill them with `keys`.
+  void place(const std::vector<std::string_view> &labels,
+             const std::vector<Slot> &keys) {
+    const std::size_t num_buckets =
+        std::bit_ceil(std::max<std::size_t>(keys.size() / 4, 8));
+    d_shift = 64 - static_cast<unsigned>(std::countr_zero(num_buckets));
+    // At most 80% full, so the last buckets still find free slots quickly.
+    std::size_t num_slots =
+        std::bit_ceil(std::max<std::size_t>(keys.size() + keys.size() / 4, 8));
+    for (unsigned attempt = 0;; ++attempt) {
+      if (attempt == k_MaxAttempts) {
+        throw std::runtime_error("stringswitch: no perfect hash found");
+      }
+      if (attempt != 0 && attempt % k_AttemptsPerSize == 0) {
+        num_slots *= 2;
+      }
+      if (num_slots > std::size_t{UINT32_MAX} + 1) {
+        throw std::length_error("stringswitch: too many labels to compile");
+      }
+      d_seed = 0xFF51AFD7ED558CCDu * (attempt + 1);
+      d_mask = static_cast<std::uint32_t>(num_slots - 1);
+      if (try_place(labels, keys, num_buckets)) {
+        return;
+      }
+    }
+  }
+
+  bool try_place(const std::vector<std::string_view> &labels,
+                 const std::vector<Slot> &keys,
+                 std::size_t num_buckets) {
+    const std::size_t num_slots = std::size_t{d_mask} + 1;
+    std::vector<std::uint64_t> hashes(keys.size());
+    // `members[first[bucket], first[bucket + 1])` are the keys in a bucket.
+    std::vector<std::uint32_t> first(num_buckets + 1, 0);
+    for (std::size_t idx = 0; idx != keys.size(); ++idx) {
+      hashes[idx] = hash(labels[idx], keys[idx].print, d_seed);
+      ++first[(hashes[idx] >> d_shift) + 1];
+    }
+    for (std::size_t bucket = 0; bucket != num_buckets; ++bucket) {
+      first[bucket + 1] += first[bucket];
+    }
+    std::vector<std::uint32_t> members(keys.size());
+    std::vector<std::uint32_t> fill(first.begin(), first.end() - 1);
+    for (std::uint32_t idx = 0; idx != keys.size(); ++idx) {
+      members[fill[hashes[idx] >> d_shift]++] = idx;
+    }
+
+    // Place the largest buckets first, while most slots are free.
+    std::vector<std::uint32_t> buckets(num_buckets);
+    for (std::uint32_t bucket = 0; bucket != num_buckets; ++bucket) {
+      buckets[bucket] = bucket;
+    }
+    auto bucket_size = [&](std::uint32_t bucket) {
+      return first[bucket + 1] - first[bucket];
+    };
+    std::sort(buckets.begin(), buckets.end(), [&](auto lhs, auto rhs) {
+      return bucket_size(lhs) != bucket_size(rhs)
+                 ? bucket_size(lhs) > bucket_size(rhs)
+                 : lhs < rhs;
+    });
+
+    std::vector<std::uint32_t> owners(num_slots, k_Miss);
+    std::vector<std::uint32_t> displacements(num_buckets, 0);
+    for (std::uint32_t bucket : buckets) {
+      if (bucket_size(bucket) == 0) {
+        break;
+      }
+      const std::uint32_t *begin = &members[first[bucket]];
+      const std::uint32_t *end = begin + bucket_size(bucket);
+      bool placed = false;
+      // The step is odd, so a lone key tries every slot.
+      for (std::size_t displacement = 0;
+           !placed && displacement != num_slots;
+           ++displacement) {
+        const auto d = static_cast<std::uint32_t>(displacement);
+        const std::uint32_t *member = begin;
+        for (; member != end; ++member) {
+          std::uint32_t &owner = owners[slot_of(hashes[*member], d, d_mask)];
+          if (owner != k_Miss) {
+            break;
+          }
+          owner = *member;
+        }
+        placed = member == end;
+        if (placed) {
+          displacements[bucket] = d;
+        }
+        while (!placed && member != begin) {
+          owners[slot_of(hashes[*--member], d, d_mask)] = k_Miss;
+        }
+      }
+      if (!placed) {
+        return false;
+      }
+    }
+
+    d_slots.assign(num_slots, Slot{{0, 0}, 0, k_Miss});
+    for (std::size_t pos = 0; pos != num_slots; ++pos) {
+      if (owners[pos] != k_Miss) {
+        d_slots[pos] = keys[owners[pos]];
+      }
+    }
+    d_displacements = std::move(displacements);
+    return true;
+  }
+
+  std::uint64_t d_seed = 0;
+  // The bucket of a hash is `hash >> d_shift`.
+  unsigned d_shift = 63;
+  std::uint32_t d_mask = 0;
+  std::vector<std::uint32_t> d_displacements;
+  std::vector<Slot> d_slots;
+  std::string d_bytes;
+};
+
+#if STRINGSWITCH_JIT
+
+/// A `PerfectHash` lookup translated into x86-64 machine code.
+///
+/// The generated function follows the System V calling convention, taking the
+/// key's data in `rdi` and size in `rsi` and returning the label index in
+/// `eax`. The seed, shift, mask, and the addresses of the displacements and
+/// slots are immediate constants, so a lookup of a key of up to
+/// `Fingerprint::k_Size` bytes is straight-line code up to the compare against
+/// the slot. Longer keys are passed on to `PerfectHash::find_long`. The code
+/// is written to private anonymous memory that is then made executable and
+/// read-only.
+class NativePerfectHash {
+public:
+  using Function = std::uint32_t (*)(const char *data, std::size_t size);
+
+  /// Translate `table`, which the generated code keeps referring to.
+  /// `function()` is null if executable memory could not be obtained.
+  explicit NativePerfectHash(std::shared_ptr<const PerfectHash> table)
+      : d_table(std::move(table)) {
+    using Slot = PerfectHash::Slot;
+    static_assert(sizeof(Slot) == 32 && offsetof(Slot, size) == 16 &&
+                  offsetof(Slot, label) == 20);
+    Assembler code;
+
+    code.emit({0x48, 0x83, 0xFE,             // cmp rsi, k_Size
+               static_cast<unsigned char>(Fingerprint::k_Size)});
+    const std::size_t to_long = code.jump_if(k_Above);
+
+    // The fingerprint, as `Fingerprint::of` computes it, in rax and rdx.
+    code.emit({0x48, 0x83, 0xFE, 0x08});     // cmp rsi, 8
+    const std::size_t to_short = code.jump_if(k_Below);
+    code.emit({0x48, 0x8B, 0x07,             // mov rax, [rdi]
+               0x48, 0x8B, 0x54, 0x37,       // mov rdx, [rdi + rsi - 8]
+               0xF8});
+    const std::size_t long_done = code.jump();
+    code.patch(to_short, code.size());
+    code.emit({0x31, 0xD2,                   // xor edx, edx
+               0x48, 0x83, 0xFE, 0x04});     // cmp rsi, 4
+    const std::size_t to_tiny = code.jump_if(k_Below);
+    code.emit({0x8B, 0x07,                   // mov eax, [rdi]
+               0x8B, 0x4C, 0x37, 0xFC,       // mov ecx, [rdi + rsi - 4]
+               0x48, 0xC1, 0xE1, 0x20,       // shl rcx, 32
+               0x48, 0x09, 0xC8});           // or rax, rcx
+    const std::size_t short_done = code.jump();
+    code.patch(to_tiny, code.size());
+    code.emit({0x31, 0xC0,                   // xor eax, eax
+               0x48, 0x85, 0xF6});           // test rsi, rsi
+    const std::size_t empty_done = code.jump_if(k_Equal);
+    code.emit({0x0F, 0xB6, 0x07,             // movzx eax, byte [rdi]
+               0x48, 0x89, 0xF1,             // mov rcx, rsi
+               0x48, 0xD1, 0xE9,             // shr rcx, 1
+               0x0F, 0xB6, 0x0C, 0x0F,       // movzx ecx, byte [rdi + rcx]
+               0xC1, 0xE1, 0x08,             // shl ecx, 8
+               0x09, 0xC8,                   // or eax, ecx
+               0x0F, 0xB6, 0x4C, 0x37, 0xFF, // movzx ecx, byte [rdi + rsi - 1]
+               0xC1, 0xE1, 0x10,             // shl ecx, 16
+               0x09, 0xC8});                 // or eax, ecx
+    for (std::size_t at : {long_done, short_done, empty_done}) {
+      code.patch(at, code.size());
+    }
+
+    // Keep the fingerprint in r8 and r9, and `PerfectHash::hash` in rax.
+    code.emit({0x49, 0x89, 0xC0,             // mov r8, rax
+               0x49, 0x89, 0xD1});           // mov r9, rdx
+    code.mov_rcx(d_table->seed());
+    code.emit({0x48, 0x31, 0xC8});           // xor rax, rcx
+    code.mov_rcx(PerfectHash::k_Mul[0]);
+    code.emit({0x48, 0x0F, 0xAF, 0xC1,       // imul rax, rcx
+               0x48, 0x89, 0xC1,             // mov rcx, rax
+               0x48, 0xC1, 0xE9, 0x20,       // shr rcx, 32
+               0x48, 0x31, 0xC8,             // xor rax, rcx
+               0x48, 0x31, 0xD0});           // xor rax, rdx
+    code.mov_rcx(PerfectHash::k_Mul[1]);
+    code.emit({0x48, 0x0F, 0xAF, 0xC1,       // imul rax, rcx
+               0x48, 0x89, 0xC1,             // mov rcx, rax
+               0x48, 0xC1, 0xE9, 0x20,       // shr rcx, 32
+               0x48, 0x31, 0xC8,             // xor rax, rcx
+               0x48, 0x31, 0xF0});           // xor rax, rsi
+    code.mov_rcx(PerfectHash::k_Mul[2]);
+    code.emit({0x48, 0x0F, 0xAF, 0xC1,       // imul rax, rcx
+               0x48, 0x89, 0xC2,             // mov rdx, rax
+               0x48, 0xC1, 0xEA, 0x20,       // shr rdx, 32
+               0x48, 0x31, 0xD0});           // xor rax, rdx
+
+    // The address of the slot, as `PerfectHash::position` computes it, in
+    // rdx.
+    code.emit({0x48, 0x89, 0xC2,             // mov rdx, rax
+               0x48, 0xC1, 0xEA,             // shr rdx, shift
+               static_cast<unsigned char>(d_table->shift())});
+    code.mov_rcx(reinterpret_cast<std::uintptr_t>(d_table->displacements()));
+    code.emit({0x8B, 0x0C, 0x91,             // mov ecx, [rcx + rdx * 4]
+               0x48, 0x89, 0xC2,             // mov rdx, rax
+               0x48, 0xC1, 0xEA, 0x20,       // shr rdx, 32
+               0x83, 0xCA, 0x01,             // or edx, 1
+               0x0F, 0xAF, 0xCA,             // imul ecx, edx
+               0x01, 0xC1,                   // add ecx, eax
+               0x81, 0xE1});                 // and ecx, mask
+    code.emit_value(d_table->mask());
+    code.emit({0x48, 0xC1, 0xE1, 0x05});     // shl rcx, 5
+    code.emit({0x48, 0xBA});                 // mov rdx, slots
+    code.emit_value(reinterpret_cast<std::uintptr_t>(d_table->slots()));
+    code.emit({0x48, 0x01, 0xCA});           // add rdx, rcx
+
+    // Verify the size and fingerprint.
+    code.emit({0x8B, 0x4A, 0x10,             // mov ecx, [rdx + 16]
+               0x48, 0x39, 0xF1});           // cmp rcx, rsi
+    const std::size_t size_differs = code.jump_if(k_NotEqual);
+    code.emit({0x4C, 0x3B, 0x02});           // cmp r8, [rdx]
+    const std::size_t head_differs = code.jump_if(k_NotEqual);
+    code.emit({0x4C, 0x3B, 0x4A, 0x08});     // cmp r9, [rdx + 8]
+    const std::size_t tail_differs = code.jump_if(k_NotEqual);
+    code.emit({0x8B, 0x42, 0x14,             // mov eax, [rdx + 20]
+               0xC3});                       // ret
+
+    for (std::size_t at : {size_differs, head_differs, tail_differs}) {
+      code.patch(at, code.size());
+    }
+    code.emit({0xB8});                       // mov eax, k_Miss
+    code.emit_value(PerfectHash::k_Miss);
+    code.emit({0xC3});                       // ret
+
+    // Tail-call `find_long(data, size, table)`.
+    code.patch(to_long, code.size());
+    code.emit({0x48, 0xBA});                 // mov rdx, table
+    code.emit_value(reinterpret_cast<std::uintptr_t>(d_table.get()));
+    code.emit({0x48, 0xB8});                 // mov rax, find_long
+    code.emit_value(reinterpret_cast<std::uintptr_t>(&PerfectHash::find_long));
+    code.emit({0xFF, 0xE0});                 // jmp rax
+    publish(code.bytes());
+  }
+
+  NativePerfectHash(const NativePerfectHash &) = delete;
+  NativePerfectHash &operator=(const NativePerfectHash &) = delete;
+
+  ~NativePerfectHash() {
+    if (d_memory != nullptr) {
+      ::munmap(d_memory, d_mapped_size);
+    }
+  }
+
+  Function function() const { return d_function; }
+
+private:
+  // Just enough of an x86-64 encoder for the lookup. Jumps use 32-bit
+  // displacements, recorded by the offset of the displacement.
+  class Assembler {
+  public:
+    std::size_t size() const { return d_bytes.size(); }
+
+    const std::vector<unsigned char> &bytes() const { return d_bytes; }
+
+    void emit(std::initializer_list<unsigned char> bytes) {
+      d_bytes.insert(d_bytes.end(), bytes);
+    }
+
+    template <class Value>
+    std::size_t emit_value(Value value) {
+      const std::size_t at = d_bytes.size();
+      d_bytes.resize(at + sizeof(value));
+      std::memcpy(&d_bytes[at], &value, sizeof(value));
+      return at;
+    }
+
+    void mov_rcx(std::uint64_t value) {
+      // mov rcx, imm64
+      emit({0x48, 0xB9});
+      emit_value(value);
+    }
+
+    // Emit a jump (`jmp`, or `jcc` with condition code `cc`) and return the
+    // offset of its displacement.
+    std::size_t jump() {
+      emit({0xE9});
+      return emit_value(std::uint32_t{0});
+    }
+
+    std::size_t jump_if(unsigned char cc) {
+      emit({0x0F, static_cast<unsigned char>(0x80 | cc)});
+      return emit_value(std::uint32_t{0});
+    }
+
+    void patch(std::size_t at, std::size_t target) {
+      const auto displacement =
+          static_cast<std::int32_t>(static_cast<std::int64_t>(target) -
+                                    static_cast<std::int64_t>(at + 4));
+      std::memcpy(&d_bytes[at], &displacement, sizeof(displacement));
+    }
+
+  private:
+    std::vector<unsigned char> d_bytes;
+  };
+
+  static constexpr unsigned char k_Below = 0x2;
+  static constexpr unsigned char k_Equal = 0x4;
+  static constexpr unsigned char k_NotEqual = 0x5;
+  static constexpr unsigned char k_Above = 0x7;
+
+  void publish(const std::vector<unsigned char> &bytes) {
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t size = (bytes.size() + page - 1) / page * page;
+    void *memory = ::mmap(nullptr,
+                          size,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1,
+                          0);
+    if (memory == MAP_FAILED) {
+      return;
+    }
+    std::memcpy(memory, bytes.data(), bytes.size());
+    if (::mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+      ::munmap(memory, size);
+      return;
+    }
+    d_memory = memory;
+    d_mapped_size = size;
+    d_function = reinterpret_cast<Function>(memory);
+  }
+
+  std::shared_ptr<const PerfectHash> d_table;
+  void *d_memory = nullptr;
+  std::size_t d_mapped_size = 0;
+  Function d_function = nullptr;
+};
+
+#endif // STRINGSWITCH_JIT
+
+} // namespace detail
+
+/// A stringswitch whose cases are compiled for repeated lookups, for label
+/// sets that are only known at runtime but then queried very often.
+///
+/// The cases are compiled into a `detail::PerfectHash`, so a lookup hashes
+/// the key's size and first and last 8 bytes, reads one slot, and verifies
+/// the key against the single label found there. On x86-64 Linux the lookup
+/// is translated to machine code with the table's parameters as immediate
+/// constants; elsewhere, with `JitMode::k_Interpret`, or if executable memory
+/// is unavailable, the same table is searched in C++. Both give the same
+/// results as `sw.evaluate`.
+///
+/// The switch is copied, so later changes to it are not reflected. Copies of
+/// a `CompiledSwitch` share the table and the generated code.
+template <detail::LateBoundSwitch Switch>
+class CompiledSwitch {
+public:
+  using EffectiveResultType = typename Switch::EffectiveResultType;
+
+  explicit CompiledSwitch(const Switch &sw, JitMode mode = JitMode::k_Auto)
+      : d_switch(sw) {
+    std::vector<std::string_view> labels;
+    detail::SwitchAccess::for_each_case(
+        d_switch, [&](std::string_view label, const auto &result) {
+          labels.push_back(label);
+          d_results.push_back(result);
+        });
+    d_table = std::make_shared<const detail::PerfectHash>(labels);
+#if STRINGSWITCH_JIT
+    if (mode == JitMode::k_Auto) {
+      auto native = std::make_shared<const detail::NativePerfectHash>(d_table);
+      if (native->function() != nullptr) {
+        d_native = std::move(native);
+      }
+    }
+#else
+    static_cast<void>(mode);
+#endif
+  }
+
+  /// Whether lookups run generated machine code.
+  bool is_native() const {
+#if STRINGSWITCH_JIT
+    return d_native != nullptr;
+#else
+    return false;
+#endif
+  }
+
+  EffectiveResultType evaluate(std::string_view param) const {
+    std::uint32_t idx;
+#if STRINGSWITCH_JIT
+    if (d_native) {
+      idx = d_native->function()(param.data(), param.size());
+    } else {
+      idx = d_table->find(param);
+    }
+#else
+    idx = d_table->find(param);
+#endif
+    if (idx == detail::PerfectHash::k_Miss) {
+      return detail::SwitchAccess::fallback(d_switch, param);
+    }
+    return d_results[idx];
+  }
+
+private:
+  Switch d_switch;
+  std::vector<typename Switch::ResultType> d_results;
+  std::shared_ptr<const detail::PerfectHash> d_table;
+#if STRINGSWITCH_JIT
+  std::shared_ptr<const detail::NativePerfectHash> d_native;
+#endif
+};
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_JIT_H
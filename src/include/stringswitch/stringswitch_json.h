@@ -0,0 +1,138 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_JSON_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_JSON_H
+
+#include "stringswitch_cpu.h"
+#include "stringswitch_impl.h"
+#include "stringswitch_utf8.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace stringswitch::detail {
+
+// The value of the hex digit `c`, or -1.
+inline int hex_digit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Parse the four hex digits of a `\u` escape starting at `data`.
+inline std::optional<std::uint32_t> parse_hex4(std::string_view data) {
+  if (data.size() < 4) {
+    return std::nullopt;
+  }
+  std::uint32_t value = 0;
+  for (std::size_t idx = 0; idx != 4; ++idx) {
+    const int digit = hex_digit(data[idx]);
+    if (digit < 0) {
+      return std::nullopt;
+    }
+    value = value << 4 | static_cast<std::uint32_t>(digit);
+  }
+  return value;
+}
+
+/// Decode the escapes of the JSON string contents `raw` (without the
+/// surrounding quotes) into `out`, returning the decoded size, or nothing if
+/// `raw` holds a malformed escape.
+///
+/// `out` must have room for `raw.size()` bytes; decoding never grows a
+/// string. `\u` escapes are encoded as UTF-8, joining surrogate pairs; a lone
+/// surrogate is malformed.
+inline std::optional<std::size_t> json_unescape(std::string_view raw,
+                                                char *out) {
+  std::size_t size = 0;
+  for (std::size_t pos = 0; pos != raw.size();) {
+    if (raw[pos] != '\\') {
+      out[size++] = raw[pos++];
+      continue;
+    }
+    if (pos + 1 == raw.size()) {
+      return std::nullopt;
+    }
+    const char escape = raw[pos + 1];
+    pos += 2;
+    switch (escape) {
+    case '"':
+    case '\\':
+    case '/':
+      out[size++] = escape;
+      continue;
+    case 'b':
+      out[size++] = '\b';
+      continue;
+    case 'f':
+      out[size++] = '\f';
+      continue;
+    case 'n':
+      out[size++] = '\n';
+      continue;
+    case 'r':
+      out[size++] = '\r';
+      continue;
+    case 't':
+      out[size++] = '\t';
+      continue;
+    case 'u':
+      break;
+    default:
+      return std::nullopt;
+    }
+    std::optional<std::uint32_t> code_point = parse_hex4(raw.substr(pos));
+    if (!code_point || (*code_point >= 0xDC00 && *code_point < 0xE000)) {
+      return std::nullopt;
+    }
+    pos += 4;
+    if (*code_point >= 0xD800 && *code_point < 0xDC00) {
+      const std::string_view rest = raw.substr(pos);
+      std::optional<std::uint32_t> low =
+          rest.starts_with("\\u") ? parse_hex4(rest.substr(2)) : std::nullopt;
+      if (!low || *low < 0xDC00 || *low >= 0xE000) {
+        return std::nullopt;
+      }
+      code_point = 0x10000 + ((*code_point - 0xD800) << 10) + (*low - 0xDC00);
+      pos += 6;
+    }
+    size += encode_utf8(*code_point, out + size);
+  }
+  return size;
+}
+
+// Escaped keys up to this size are decoded without allocating.
+inline constexpr std::size_t k_JsonBufferSize = 256;
+
+// `sw.evaluate_json_escaped(raw)`.
+template <class Switch>
+typename Switch::EffectiveResultType evaluate_escaped(const Switch &sw,
+                                                      std::string_view raw) {
+  if (kernels().find_byte(raw.data(), raw.size(), '\\') == raw.size()) {
+    return sw.evaluate(raw);
+  }
+  char buffer[k_JsonBufferSize];
+  std::string heap;
+  char *out = buffer;
+  if (raw.size() > sizeof(buffer)) {
+    heap.resize(raw.size());
+    out = heap.data();
+  }
+  const std::optional<std::size_t> size = json_unescape(raw, out);
+  if (!size) {
+    return SwitchAccess::on_miss(sw);
+  }
+  return sw.evaluate(std::string_view(out, *size));
+}
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_JSON_H
@@ -0,0 +1,459 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_KERNELS_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_KERNELS_H
+
+#include "stringswitch_hash.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Define STRINGSWITCH_DISABLE_SIMD to build only the scalar kernels.
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__)) &&                               \
+    !defined(STRINGSWITCH_DISABLE_SIMD)
+#define STRINGSWITCH_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define STRINGSWITCH_X86_KERNELS 0
+#endif
+
+namespace stringswitch::detail {
+
+// Building blocks shared by the library's lookup paths, each implemented once
+// per instruction set. Nothing in here is called directly: `kernels()` (see
+// stringswitch_cpu.h) hands out the set matching the running CPU.
+
+/// Number of keys hashed together by `hash_short_lanes_*`.
+inline constexpr std::size_t k_HashLanes = 16;
+
+/// A group of short keys laid out one word per array, so that lane `idx` of
+/// every array belongs to the same key.
+struct HashLanes {
+  alignas(64) std::uint32_t words[4][k_HashLanes];
+  alignas(64) std::uint32_t sizes[k_HashLanes];
+  alignas(64) std::uint32_t hashes[k_HashLanes];
+
+  void load(std::size_t lane, std::string_view key) {
+    const ShortKeyWords loaded = load_short_key(key.data(), key.size());
+    for (int word = 0; word != 4; ++word) {
+      words[word][lane] = loaded.words[word];
+    }
+    sizes[lane] = static_cast<std::uint32_t>(key.size());
+  }
+};
+
+/// Compute `hashes[idx] = hash_short(words[.][idx], sizes[idx])` for every
+/// lane, one lane at a time.
+inline void hash_short_lanes_scalar(HashLanes &lanes) {
+  for (std::size_t lane = 0; lane != k_HashLanes; ++lane) {
+    ShortKeyWords key;
+    for (int word = 0; word != 4; ++word) {
+      key.words[word] = lanes.words[word][lane];
+    }
+    lanes.hashes[lane] = hash_short(key, lanes.sizes[lane]);
+  }
+}
+
+#if STRINGSWITCH_X86_KERNELS
+
+// Lambdas don't inherit `target` attributes, so the vector kernels below are
+// built from helpers that carry their own.
+
+__attribute__((target("avx2"))) inline __m256i
+hash_round_avx2(__m256i hash, __m256i word, std::uint32_t mul) {
+  hash = _mm256_mullo_epi32(_mm256_xor_si256(hash, word),
+                            _mm256_set1_epi32(static_cast<int>(mul)));
+  return _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+}
+
+/// `hash_short_lanes_scalar`, eight lanes per instruction.
+__attribute__((target("avx2"))) inline void
+hash_short_lanes_avx2(HashLanes &lanes) {
+  for (std::size_t base = 0; base != k_HashLanes; base += 8) {
+    const __m256i sizes = _mm256_load_si256(
+        reinterpret_cast<const __m256i *>(lanes.sizes + base));
+    __m256i hash = _mm256_xor_si256(
+        _mm256_set1_epi32(static_cast<int>(k_HashSeed)),
+        _mm256_mullo_epi32(
+            sizes, _mm256_set1_epi32(static_cast<int>(k_HashLengthMul))));
+    for (int word = 0; word != 4; ++word) {
+      const __m256i words = _mm256_load_si256(
+          reinterpret_cast<const __m256i *>(lanes.words[word] + base));
+      hash = hash_round_avx2(hash, words, k_HashWordMul[word]);
+    }
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 16));
+    hash = _mm256_mullo_epi32(
+        hash, _mm256_set1_epi32(static_cast<int>(k_HashFinalMul)));
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes.hashes + base), hash);
+  }
+}
+
+// `_mm512_srli_epi32` trips GCC's -Wuninitialized inside its own header; the
+// all-lanes zero-masked form is the same instruction without the warning.
+__attribute__((target("avx512f"))) inline __m512i
+shift_right_avx512(__m512i value, unsigned int count) {
+  return _mm512_maskz_srli_epi32(0xFFFF, value, count);
+}
+
+__attribute__((target("avx512f"))) inline __m512i
+hash_round_avx512(__m512i hash, __m512i word, std::uint32_t mul) {
+  hash = _mm512_mullo_epi32(_mm512_xor_si512(hash, word),
+                            _mm512_set1_epi32(static_cast<int>(mul)));
+  return _mm512_xor_si512(hash, shift_right_avx512(hash, 15));
+}
+
+/// `hash_short_lanes_scalar`, all sixteen lanes per instruction.
+__attribute__((target("avx512f"))) inline void
+hash_short_lanes_avx512(HashLanes &lanes) {
+  const __m512i length_mul =
+      _mm512_set1_epi32(static_cast<int>(k_HashLengthMul));
+  __m512i hash =
+      _mm512_xor_si512(_mm512_set1_epi32(static_cast<int>(k_HashSeed)),
+                       _mm512_mullo_epi32(_mm512_load_si512(lanes.sizes),
+                                          length_mul));
+  for (int word = 0; word != 4; ++word) {
+    hash = hash_round_avx512(
+        hash, _mm512_load_si512(lanes.words[word]), k_HashWordMul[word]);
+  }
+  const __m512i final_mul = _mm512_set1_epi32(static_cast<int>(k_HashFinalMul));
+  hash = _mm512_xor_si512(hash, shift_right_avx512(hash, 16));
+  hash = _mm512_mullo_epi32(hash, final_mul);
+  hash = _mm512_xor_si512(hash, shift_right_avx512(hash, 15));
+  _mm512_store_si512(lanes.hashes, hash);
+}
+
+#endif // STRINGSWITCH_X86_KERNELS
+
+/// A slot of the library's open-addressing tables.
+struct HashSlot {
+  std::uint32_t hash = 0;
+  // One past the index of the slot's entry; zero marks a free slot.
+  std::uint32_t entry = 0;
+};
+
+/// Number of consecutive slots inspected by one `probe_group` call.
+inline constexpr std::size_t k_ProbeGroup = 8;
+
+/// Bit `idx` of `matches` (resp. `empties`) is set if slot `idx` of a probed
+/// group holds the probed hash (resp. is free).
+struct ProbeMasks {
+  std::uint32_t matches;
+  std::uint32_t empties;
+};
+
+/// Number of consecutive values inspected by one `count_below` call.
+inline constexpr std::size_t k_CountBlock = 8;
+
+/// Keep the even bits of `mask`, packed into its low half.
+inline std::uint32_t compress_even_bits(std::uint32_t mask) {
+  mask &= 0x55555555u;
+  mask = (mask | (mask >> 1)) & 0x33333333u;
+  mask = (mask | (mask >> 2)) & 0x0F0F0F0Fu;
+  mask = (mask | (mask >> 4)) & 0x00FF00FFu;
+  return (mask | (mask >> 8)) & 0x0000FFFFu;
+}
+
+// Equality of short byte ranges with overlapping loads, shared by every
+// `equal_bytes` implementation for ranges below its vector width.
+inline bool equal_bytes_small(const char *lhs,
+                              const char *rhs,
+                              std::size_t size) {
+  if (size >= 8) {
+    return ((load_u64(lhs) ^ load_u64(rhs)) |
+            (load_u64(lhs + size - 8) ^ load_u64(rhs + size - 8))) == 0;
+  }
+  if (size >= 4) {
+    return ((load_u32(lhs) ^ load_u32(rhs)) |
+            (load_u32(lhs + size - 4) ^ load_u32(rhs + size - 4))) == 0;
+  }
+  for (std::size_t idx = 0; idx != size; ++idx) {
+    if (lhs[idx] != rhs[idx]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline ProbeMasks probe_group_scalar(const HashSlot *slots,
+                                     std::uint32_t hash) {
+  ProbeMasks masks = {0, 0};
+  for (std::size_t idx = 0; idx != k_ProbeGroup; ++idx) {
+    masks.matches |= static_cast<std::uint32_t>(slots[idx].hash == hash) << idx;
+    masks.empties |= static_cast<std::uint32_t>(slots[idx].entry == 0) << idx;
+  }
+  return masks;
+}
+
+inline std::size_t count_below_scalar(const std::uint64_t *values,
+                                      std::uint64_t key) {
+  std::size_t count = 0;
+  for (std::size_t idx = 0; idx != k_CountBlock; ++idx) {
+    count += values[idx] < key;
+  }
+  return count;
+}
+
+inline bool equal_bytes_scalar(const char *lhs,
+                               const char *rhs,
+                               std::size_t size) {
+  return std::memcmp(lhs, rhs, size) == 0;
+}
+
+inline std::size_t find_byte_scalar(const char *data,
+                                    std::size_t size,
+                                    char byte) {
+  const void *found = std::memchr(data, byte, size);
+  return found != nullptr ? static_cast<const char *>(found) - data : size;
+}
+
+inline std::size_t find_non_ascii_scalar(const char *data, std::size_t size) {
+  std::size_t offset = 0;
+  for (; offset + 8 <= size; offset += 8) {
+    if ((load_u64(data + offset) & 0x8080808080808080ull) != 0) {
+      break;
+    }
+  }
+  for (; offset != size; ++offset) {
+    if (static_cast<unsigned char>(data[offset]) >= 0x80) {
+      break;
+    }
+  }
+  return offset;
+}
+
+#if STRINGSWITCH_X86_KERNELS
+
+__attribute__((target("sse2"))) inline ProbeMasks
+probe_group_sse2(const HashSlot *slots, std::uint32_t hash) {
+  const __m128i hashes = _mm_set1_epi32(static_cast<int>(hash));
+  const __m128i zero = _mm_setzero_si128();
+  std::uint32_t matches = 0;
+  std::uint32_t empties = 0;
+  for (std::size_t quarter = 0; quarter != 4; ++quarter) {
+    const __m128i pair = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(slots + 2 * quarter));
+    const auto shift = static_cast<int>(4 * quarter);
+    matches |= static_cast<std::uint32_t>(_mm_movemask_ps(
+                   _mm_castsi128_ps(_mm_cmpeq_epi32(pair, hashes))))
+               << shift;
+    empties |= static_cast<std::uint32_t>(_mm_movemask_ps(
+                   _mm_castsi128_ps(_mm_cmpeq_epi32(pair, zero))))
+               << shift;
+  }
+  return {compress_even_bits(matches), compress_even_bits(empties >> 1)};
+}
+
+__attribute__((target("sse2"))) inline bool
+chunk_differs_sse2(const char *lhs, const char *rhs) {
+  const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs));
+  const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(left, right)) != 0xFFFF;
+}
+
+__attribute__((target("sse2"))) inline bool
+equal_bytes_sse2(const char *lhs, const char *rhs, std::size_t size) {
+  if (size < 16) {
+    return equal_bytes_small(lhs, rhs, size);
+  }
+  for (std::size_t offset = 0; offset + 16 < size; offset += 16) {
+    if (chunk_differs_sse2(lhs + offset, rhs + offset)) {
+      return false;
+    }
+  }
+  // The last chunk overlaps the previous one rather than being a scalar tail.
+  return !chunk_differs_sse2(lhs + size - 16, rhs + size - 16);
+}
+
+__attribute__((target("sse2"))) inline std::size_t
+find_byte_sse2(const char *data, std::size_t size, char byte) {
+  const __m128i needle = _mm_set1_epi8(byte);
+  std::size_t offset = 0;
+  for (; offset + 16 <= size; offset += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+    const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+    if (mask != 0) {
+      return offset + std::countr_zero(static_cast<unsigned>(mask));
+    }
+  }
+  return offset + find_byte_scalar(data + offset, size - offset, byte);
+}
+
+// The byte mask of a vector is exactly its bytes' top bits.
+__attribute__((target("sse2"))) inline std::size_t
+find_non_ascii_sse2(const char *data, std::size_t size) {
+  std::size_t offset = 0;
+  for (; offset + 16 <= size; offset += 16) {
+    const int mask = _mm_movemask_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset)));
+    if (mask != 0) {
+      return offset + std::countr_zero(static_cast<unsigned>(mask));
+    }
+  }
+  return offset + find_non_ascii_scalar(data + offset, size - offset);
+}
+
+__attribute__((target("avx2"))) inline ProbeMasks
+probe_group_avx2(const HashSlot *slots, std::uint32_t hash) {
+  const __m256i hashes = _mm256_set1_epi32(static_cast<int>(hash));
+  const __m256i zero = _mm256_setzero_si256();
+  std::uint32_t matches = 0;
+  std::uint32_t empties = 0;
+  for (std::size_t half = 0; half != 2; ++half) {
+    const __m256i quad = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(slots + 4 * half));
+    const auto shift = static_cast<int>(8 * half);
+    matches |= static_cast<std::uint32_t>(_mm256_movemask_ps(
+                   _mm256_castsi256_ps(_mm256_cmpeq_epi32(quad, hashes))))
+               << shift;
+    empties |= static_cast<std::uint32_t>(_mm256_movemask_ps(
+                   _mm256_castsi256_ps(_mm256_cmpeq_epi32(quad, zero))))
+               << shift;
+  }
+  return {compress_even_bits(matches), compress_even_bits(empties >> 1)};
+}
+
+__attribute__((target("avx2"))) inline std::size_t
+count_below_avx2(const std::uint64_t *values, std::uint64_t key) {
+  // AVX2 only compares signed 64-bit lanes; flipping the sign bit of both
+  // sides turns that into the unsigned comparison.
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i keys =
+      _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(key)), sign);
+  int below = 0;
+  for (std::size_t half = 0; half != 2; ++half) {
+    const __m256i quad = _mm256_xor_si256(
+        _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(values + 4 * half)),
+        sign);
+    below |= _mm256_movemask_pd(
+                 _mm256_castsi256_pd(_mm256_cmpgt_epi64(keys, quad)))
+             << (4 * half);
+  }
+  return std::popcount(static_cast<unsigned>(below));
+}
+
+__attribute__((target("avx2"))) inline bool
+equal_bytes_avx2(const char *lhs, const char *rhs, std::size_t size) {
+  if (size < 32) {
+    return equal_bytes_sse2(lhs, rhs, size);
+  }
+  for (std::size_t offset = 0;; offset += 32) {
+    // The last chunk overlaps the previous one rather than being a scalar tail.
+    const std::size_t at = offset + 32 < size ? offset : size - 32;
+    const __m256i left =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + at));
+    const __m256i right =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + at));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(left, right)) != -1) {
+      return false;
+    }
+    if (at == size - 32) {
+      return true;
+    }
+  }
+}
+
+__attribute__((target("avx2"))) inline std::size_t
+find_byte_avx2(const char *data, std::size_t size, char byte) {
+  const __m256i needle = _mm256_set1_epi8(byte);
+  std::size_t offset = 0;
+  for (; offset + 32 <= size; offset += 32) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + offset));
+    const int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+    if (mask != 0) {
+      return offset + std::countr_zero(static_cast<unsigned>(mask));
+    }
+  }
+  return offset + find_byte_sse2(data + offset, size - offset, byte);
+}
+
+__attribute__((target("avx2"))) inline std::size_t
+find_non_ascii_avx2(const char *data, std::size_t size) {
+  std::size_t offset = 0;
+  for (; offset + 32 <= size; offset += 32) {
+    const int mask = _mm256_movemask_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + offset)));
+    if (mask != 0) {
+      return offset + std::countr_zero(static_cast<unsigned>(mask));
+    }
+  }
+  return offset + find_non_ascii_sse2(data + offset, size - offset);
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline ProbeMasks
+probe_group_avx512(const HashSlot *slots, std::uint32_t hash) {
+  const __m512i group = _mm512_loadu_si512(slots);
+  const __mmask16 matches = _mm512_mask_cmpeq_epi32_mask(
+      0x5555, group, _mm512_set1_epi32(static_cast<int>(hash)));
+  const __mmask16 empties =
+      _mm512_mask_cmpeq_epi32_mask(0xAAAA, group, _mm512_setzero_si512());
+  return {compress_even_bits(matches),
+          compress_even_bits(static_cast<std::uint32_t>(empties) >> 1)};
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline std::size_t
+count_below_avx512(const std::uint64_t *values, std::uint64_t key) {
+  const __mmask8 below =
+      _mm512_cmplt_epu64_mask(_mm512_loadu_si512(values),
+                              _mm512_set1_epi64(static_cast<long long>(key)));
+  return std::popcount(static_cast<unsigned>(below));
+}
+
+// Masked loads only touch the bytes they select, so the AVX-512 kernels below
+// finish with a partial vector rather than a scalar tail.
+__attribute__((target("avx512f,avx512bw"))) inline __mmask64
+leading_bytes_avx512(std::size_t count) {
+  return count >= 64 ? ~__mmask64{0} : (__mmask64{1} << count) - 1;
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline bool
+equal_bytes_avx512(const char *lhs, const char *rhs, std::size_t size) {
+  for (std::size_t offset = 0; offset < size; offset += 64) {
+    const __mmask64 valid = leading_bytes_avx512(size - offset);
+    const __m512i left = _mm512_maskz_loadu_epi8(valid, lhs + offset);
+    const __m512i right = _mm512_maskz_loadu_epi8(valid, rhs + offset);
+    if (_mm512_cmpneq_epi8_mask(left, right) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline std::size_t
+find_byte_avx512(const char *data, std::size_t size, char byte) {
+  const __m512i needle = _mm512_set1_epi8(byte);
+  for (std::size_t offset = 0; offset < size; offset += 64) {
+    const __mmask64 valid = leading_bytes_avx512(size - offset);
+    const __m512i chunk = _mm512_maskz_loadu_epi8(valid, data + offset);
+    const __mmask64 found = _mm512_mask_cmpeq_epi8_mask(valid, chunk, needle);
+    if (found != 0) {
+      return offset + std::countr_zero(found);
+    }
+  }
+  return size;
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline std::size_t
+find_non_ascii_avx512(const char *data, std::size_t size) {
+  for (std::size_t offset = 0; offset < size; offset += 64) {
+    const __m512i chunk = _mm512_maskz_loadu_epi8(
+        leading_bytes_avx512(size - offset), data + offset);
+    // Bytes past the end load as zero, which is ASCII.
+    const __mmask64 found = _mm512_movepi8_mask(chunk);
+    if (found != 0) {
+      return offset + std::countr_zero(found);
+    }
+  }
+  return size;
+}
+
+#endif // STRINGSWITCH_X86_KERNELS
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_KERNELS_H
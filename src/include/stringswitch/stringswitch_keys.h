@@ -0,0 +1,384 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_KEYS_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_KEYS_H
+
+#include "stringswitch_hash.h"
+#include "stringswitch_utf8.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stringswitch {
+
+// Key traits describe what a stringswitch is keyed on. Each provides:
+//
+// * `Label`: the owned form of a key, stored for every case.
+// * `Param`: the borrowed form of a key, taken by `when`, `create` and
+//   `evaluate`.
+// * `Hash` and `Equal`: transparent function objects over both forms.
+// * `own(param)` and `view(label)` converting between the two forms.
+
+namespace detail {
+
+// Hashes owned labels and borrowed parameters alike, so lookups with a
+// `std::basic_string_view` don't have to materialize a string first.
+template <class CharT>
+struct TransparentStringHash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::basic_string_view<CharT> value) const {
+    return std::hash<std::basic_string_view<CharT>>{}(value);
+  }
+};
+
+} // namespace detail
+
+/// Keys a stringswitch on strings of `CharT` (`char`, `char8_t`, `char16_t`,
+/// `char32_t` or `wchar_t`), matched code unit by code unit.
+template <class CharT>
+struct BasicStringKey {
+  using Label = std::basic_string<CharT>;
+  using Param = std::basic_string_view<CharT>;
+  using Hash = detail::TransparentStringHash<CharT>;
+  using Equal = std::equal_to<>;
+
+  static Label own(Param param) { return Label(param); }
+  static Param view(const Label &label) { return label; }
+};
+
+/// Keys a stringswitch on a single string. This is the default.
+using StringKey = BasicStringKey<char>;
+
+/// Keys a stringswitch on UTF-8 labels that can be matched by UTF-8 strings
+/// as well as by strings of `CharT` code units: UTF-16 for `char16_t`, UTF-32
+/// for `char32_t` and either for `wchar_t`, following its width.
+///
+/// ```cpp
+/// auto switcher = StringSwitch<Header, TranscodingKey<char16_t>>::create()
+///                     .when("content-type", Header::k_ContentType)
+///                     .on_default(Header::k_Other);
+/// switcher.evaluate(u"content-type"); // Header::k_ContentType
+/// ```
+///
+/// Wide parameters are transcoded to UTF-8 one code point at a time while
+/// they are hashed and compared, never into a buffer. A parameter holding a
+/// malformed sequence, such as a lone surrogate, matches no label, whether it
+/// is passed to `evaluate` or bound with `create`; a malformed label throws.
+template <class CharT>
+struct TranscodingKey {
+  using Label = std::string;
+  using WideView = std::basic_string_view<CharT>;
+
+  /// A UTF-8 or a wide string, borrowed.
+  class Param {
+  public:
+    Param(std::string_view utf8) : d_utf8(utf8) {}
+    Param(const std::string &utf8) : d_utf8(utf8) {}
+    Param(const char *utf8) : d_utf8(utf8) {}
+    Param(WideView wide) : d_wide(wide), d_is_wide(true) {}
+    Param(const std::basic_string<CharT> &wide)
+        : d_wide(wide), d_is_wide(true) {}
+    Param(const CharT *wide) : d_wide(wide), d_is_wide(true) {}
+
+    bool is_wide() const { return d_is_wide; }
+    std::string_view utf8() const { return d_utf8; }
+    WideView wide() const { return d_wide; }
+
+  private:
+    std::string_view d_utf8;
+    WideView d_wide;
+    bool d_is_wide = false;
+  };
+
+  struct Hash {
+    using is_transparent = void;
+
+    std::size_t operator()(const Label &label) const {
+      detail::StreamingHash hash;
+      hash.add(label);
+      return hash.value();
+    }
+
+    std::size_t operator()(const Param &param) const {
+      detail::StreamingHash hash;
+      if (!param.is_wide()) {
+        hash.add(param.utf8());
+      } else {
+        // A malformed parameter hashes like the bytes decoded before the
+        // error; it can't match anyway.
+        for_each_utf8(param.wide(), [&hash](std::string_view bytes) {
+          // At most 4 bytes: skip the word-at-a-time path.
+          for (char c : bytes) {
+            hash.add(static_cast<unsigned char>(c));
+          }
+          return true;
+        });
+      }
+      return hash.value();
+    }
+  };
+
+  struct Equal {
+    using is_transparent = void;
+
+    bool operator()(const Label &lhs, const Label &rhs) const {
+      return lhs == rhs;
+    }
+
+    bool operator()(const Param &param, const Label &label) const {
+      return matches(param, label);
+    }
+
+    bool operator()(const Label &label, const Param &param) const {
+      return matches(param, label);
+    }
+  };
+
+  /// Throws `std::invalid_argument` if `param` is malformed.
+  static Label own(const Param &param) {
+    std::optional<Label> label = try_own(param);
+    if (!label) {
+      throw std::invalid_argument("stringswitch: label is not valid Unicode");
+    }
+    return *std::move(label);
+  }
+
+  /// `param` as UTF-8, or nothing if it is malformed. Used for parameters
+  /// bound early, which match no label when malformed instead of throwing.
+  static std::optional<Label> try_own(const Param &param) {
+    if (!param.is_wide()) {
+      return Label(param.utf8());
+    }
+    Label label;
+    const bool valid = for_each_utf8(param.wide(), [&](std::string_view bytes) {
+      label.append(bytes);
+      return true;
+    });
+    if (!valid) {
+      return std::nullopt;
+    }
+    return label;
+  }
+
+  static Param view(const Label &label) { return label; }
+
+private:
+  // Invoke `visit(bytes)` with the UTF-8 encoding of each code point of
+  // `wide` until it returns false. Returns whether `wide` was visited to the
+  // end without a malformed sequence.
+  template <class Visitor>
+  static bool for_each_utf8(WideView wide, Visitor &&visit) {
+    char bytes[4];
+    for (std::size_t pos = 0; pos != wide.size();) {
+      const std::uint32_t code_point = detail::decode_code_point(wide, pos);
+      if (code_point == detail::k_InvalidCodePoint) {
+        return false;
+      }
+      if (!visit(std::string_view(bytes,
+                                  detail::encode_utf8(code_point, bytes)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool matches(const Param &param, const Label &label) {
+    if (!param.is_wide()) {
+      return param.utf8() == label;
+    }
+    // Each code unit encodes to at least one byte.
+    if (param.wide().size() > label.size()) {
+      return false;
+    }
+    std::size_t offset = 0;
+    const bool equal =
+        for_each_utf8(param.wide(), [&](std::string_view bytes) {
+          if (std::string_view(label).substr(offset, bytes.size()) != bytes) {
+            return false;
+          }
+          offset += bytes.size();
+          return true;
+        });
+    return equal && offset == label.size();
+  }
+};
+
+/// Keys a stringswitch on a tuple of `Arity` strings, such as an HTTP method
+/// and a content type, without concatenating them.
+///
+/// ```cpp
+/// auto switcher = StringSwitch<Handler, CompositeKey<2>>::create()
+///                     .when({"GET", "json"}, Handler::k_GetJson)
+///                     .on_default(Handler::k_Unsupported);
+/// switcher.evaluate({method, content_type});
+/// ```
+///
+/// Components are hashed separately and their hashes combined, and keys are
+/// compared component by component, so `{"ab", "c"}` and `{"a", "bc"}` are
+/// different keys.
+template <std::size_t Arity>
+struct CompositeKey {
+  static_assert(Arity > 0, "a composite key needs at least one component");
+
+  using Label = std::array<std::string, Arity>;
+  using Param = std::array<std::string_view, Arity>;
+
+  struct Hash {
+    using is_transparent = void;
+
+    template <class Key>
+    std::size_t operator()(const Key &key) const {
+      std::uint64_t hash = 0;
+      for (std::size_t idx = 0; idx != Arity; ++idx) {
+        const std::size_t component =
+            std::hash<std::string_view>{}(std::string_view(key[idx]));
+        hash = (hash ^ component) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 32;
+      }
+      return static_cast<std::size_t>(hash);
+    }
+  };
+
+  struct Equal {
+    using is_transparent = void;
+
+    template <class Lhs, class Rhs>
+    bool operator()(const Lhs &lhs, const Rhs &rhs) const {
+      for (std::size_t idx = 0; idx != Arity; ++idx) {
+        if (std::string_view(lhs[idx]) != std::string_view(rhs[idx])) {
+          return false;
+        }
+      }
+      return true;
+    }
+  };
+
+  static Label own(const Param &param) {
+    Label label;
+    for (std::size_t idx = 0; idx != Arity; ++idx) {
+      label[idx] = std::string(param[idx]);
+    }
+    return label;
+  }
+
+  static Param view(const Label &label) {
+    Param param;
+    for (std::size_t idx = 0; idx != Arity; ++idx) {
+      param[idx] = label[idx];
+    }
+    return param;
+  }
+};
+
+namespace detail {
+
+inline std::string_view as_chars(std::span<const std::byte> bytes) {
+  return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+}
+
+} // namespace detail
+
+/// Keys a stringswitch on byte strings of any length, such as opcodes or
+/// tags sliced out of a binary message, without converting them to text.
+///
+/// ```cpp
+/// auto switcher = StringSwitch<Opcode, BytesKey>::create()
+///                     .when(std::as_bytes(std::span(k_Ping)), Opcode::k_Ping)
+///                     .on_default(Opcode::k_Unknown);
+/// switcher.evaluate(payload.subspan(offset, tag_size));
+/// ```
+struct BytesKey {
+  using Label = std::vector<std::byte>;
+  using Param = std::span<const std::byte>;
+
+  struct Hash {
+    using is_transparent = void;
+
+    std::size_t operator()(Param key) const {
+      return detail::hash_bytes(detail::as_chars(key));
+    }
+  };
+
+  struct Equal {
+    using is_transparent = void;
+
+    bool operator()(Param lhs, Param rhs) const {
+      return detail::as_chars(lhs) == detail::as_chars(rhs);
+    }
+  };
+
+  static Label own(Param param) { return Label(param.begin(), param.end()); }
+  static Param view(const Label &label) { return label; }
+};
+
+/// Keys a stringswitch on exactly `Size` bytes, such as a 4-byte magic number
+/// or a 16-byte UUID.
+///
+/// ```cpp
+/// auto switcher = StringSwitch<Format, FixedKey<4>>::create()
+///                     .when(k_ElfMagic, Format::k_Elf)
+///                     .on_default(Format::k_Unknown);
+/// switcher.evaluate(header.first<4>());
+/// ```
+///
+/// Labels are stored inline. Keys of up to 16 bytes are compared as two
+/// 64-bit integers, assembled with the same loads that hash them, rather than
+/// byte by byte.
+template <std::size_t Size>
+struct FixedKey {
+  static_assert(Size > 0, "a fixed key needs at least one byte");
+
+  using Label = std::array<std::byte, Size>;
+  using Param = std::span<const std::byte, Size>;
+
+  struct Hash {
+    using is_transparent = void;
+
+    std::size_t operator()(Param key) const {
+      return detail::hash_bytes(detail::as_chars(key));
+    }
+  };
+
+  struct Equal {
+    using is_transparent = void;
+
+    bool operator()(Param lhs, Param rhs) const {
+      if constexpr (Size <= detail::k_ShortKeySize) {
+        // The words determine keys of this size, see `load_short_key`.
+        const auto left = words(lhs);
+        const auto right = words(rhs);
+        return ((left[0] ^ right[0]) | (left[1] ^ right[1])) == 0;
+      } else {
+        return detail::as_chars(lhs) == detail::as_chars(rhs);
+      }
+    }
+  };
+
+  static Label own(Param param) {
+    Label label;
+    std::copy(param.begin(), param.end(), label.begin());
+    return label;
+  }
+
+  static Param view(const Label &label) { return label; }
+
+private:
+  static std::array<std::uint64_t, 2> words(Param key) {
+    const detail::ShortKeyWords short_key = detail::load_short_key(
+        reinterpret_cast<const char *>(key.data()), Size);
+    return {short_key.words[0] | (std::uint64_t{short_key.words[1]} << 32),
+            short_key.words[2] | (std::uint64_t{short_key.words[3]} << 32)};
+  }
+};
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_KEYS_H
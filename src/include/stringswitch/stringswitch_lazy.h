@@ -0,0 +1,145 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_LAZY_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_LAZY_H
+
+#include <atomic>
+#include <concepts>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace stringswitch {
+
+/// A stringswitch result of type `T` that may be built on first use, for
+/// results that are expensive to build (compiled patterns, parsers, large
+/// tables) and that most processes never reach.
+///
+/// ```cpp
+/// auto patterns = StringSwitch<Lazy<std::regex>>::create()
+///                     .when_lazy("email", [] { return std::regex(k_Email); })
+///                     .when_lazy("phone", [] { return std::regex(k_Phone); })
+///                     .on_default(std::regex(".*"));
+/// patterns.evaluate(field).get(); // builds the matching regex once
+/// ```
+///
+/// `get` builds the value with the factory the first time it is called, from
+/// whichever thread gets there first, under a mutex that concurrent callers
+/// wait on. Later calls are a single acquire load. If the factory throws, the
+/// exception propagates and the next `get` tries again. Factories may be
+/// move-only.
+///
+/// Copies share their value, so a result is built at most once whichever
+/// copy, or copy of the switch, it is reached through. The switch holds the
+/// owning copies; the results its lookups return are borrowed (see
+/// `borrow`), so a hit copies a pointer rather than updating a reference
+/// count that every thread using the switch shares. A result returned by
+/// `evaluate(param)` is valid as long as the switch it came from is, and is
+/// not changed by later cases. `evaluate()` on an early-bound switch, which
+/// is usually a temporary, returns an owning copy.
+template <class T>
+class Lazy {
+public:
+  using ValueType = T;
+
+  /// A result that is built already.
+  Lazy(T value) : d_owner(std::make_shared<State>()), d_state(d_owner.get()) {
+    d_state->value.emplace(std::move(value));
+    d_state->built.store(true, std::memory_order_release);
+  }
+
+  /// A result built by `factory()` on first use.
+  template <class Factory>
+  requires std::move_constructible<Factory> &&
+           std::convertible_to<std::invoke_result_t<Factory &>, T>
+  static Lazy deferred(Factory factory) {
+    return Lazy(std::make_shared<State>(
+        std::make_unique<FactoryOf<Factory>>(std::move(factory))));
+  }
+
+  /// A copy that refers to the same value without owning it, so copying it
+  /// touches no reference count. It must not outlive `*this`, or the owning
+  /// copies of it.
+  Lazy borrow() const { return Lazy(d_state); }
+
+  /// The value, building it first if needed.
+  const T &get() const {
+    if (!d_state->built.load(std::memory_order_acquire)) {
+      build();
+    }
+    return *d_state->value;
+  }
+
+  const T &operator*() const { return get(); }
+  const T *operator->() const { return &get(); }
+
+  /// Whether the value has been built.
+  bool is_built() const {
+    return d_state->built.load(std::memory_order_acquire);
+  }
+
+private:
+  // A factory of any callable type, which `std::function` can't hold when it
+  // is move-only.
+  struct Factory {
+    virtual ~Factory() = default;
+    virtual T make() = 0;
+  };
+
+  template <class Callable>
+  struct FactoryOf final : Factory {
+    explicit FactoryOf(Callable callable) : d_callable(std::move(callable)) {}
+
+    T make() override { return d_callable(); }
+
+    Callable d_callable;
+  };
+
+  struct State {
+    State() = default;
+
+    explicit State(std::unique_ptr<Factory> make)
+        : factory(std::move(make)) {}
+
+    std::unique_ptr<Factory> factory;
+    std::mutex mutex;
+    std::optional<T> value;
+    std::atomic<bool> built{false};
+  };
+
+  explicit Lazy(std::shared_ptr<State> owner)
+      : d_owner(std::move(owner)), d_state(d_owner.get()) {}
+
+  // Borrowed.
+  explicit Lazy(State *state) : d_state(state) {}
+
+  // Not `std::call_once`: with libstdc++ it can deadlock once the factory
+  // has thrown.
+  void build() const {
+    State &state = *d_state;
+    std::lock_guard lock(state.mutex);
+    if (!state.built.load(std::memory_order_relaxed)) {
+      state.value.emplace(state.factory->make());
+      // Release whatever the factory captured.
+      state.factory = nullptr;
+      state.built.store(true, std::memory_order_release);
+    }
+  }
+
+  // Null in borrowed copies.
+  std::shared_ptr<State> d_owner;
+  State *d_state;
+};
+
+namespace detail {
+
+// A `Lazy` result as a lookup hands it out, see stringswitch_impl.h.
+template <class T>
+Lazy<T> lookup_result(const Lazy<T> &result) {
+  return result.borrow();
+}
+
+} // namespace detail
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_LAZY_H
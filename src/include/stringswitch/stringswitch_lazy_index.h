@@ -0,0 +1,74 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_LAZY_INDEX_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_LAZY_INDEX_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace stringswitch::detail {
+
+/// A derived, immutable index over the cases of a stringswitch that is built
+/// on first use and then shared by every copy of the switch made after it was
+/// built.
+///
+/// `get` may be called concurrently. The first call builds the index under a
+/// mutex, which concurrent callers wait on. Once published, `get` is a single
+/// acquire load of a plain pointer: ownership is held apart from it, so
+/// readers never touch a reference count.
+///
+/// Modifying the cases the index was derived from must be followed by
+/// `reset`, which is not safe to call concurrently with `get`.
+template <class Index>
+class LazyIndex {
+public:
+  LazyIndex() = default;
+
+  LazyIndex(const LazyIndex &other) { *this = other; }
+
+  LazyIndex &operator=(const LazyIndex &other) {
+    if (this != &other) {
+      std::shared_ptr<const Index> owner;
+      {
+        std::lock_guard lock(other.d_mutex);
+        owner = other.d_owner;
+      }
+      std::lock_guard lock(d_mutex);
+      d_owner = std::move(owner);
+      d_index.store(d_owner.get(), std::memory_order_release);
+    }
+    return *this;
+  }
+
+  /// The index, building it with `build()` if it doesn't exist yet.
+  template <class Build>
+  const Index &get(Build &&build) const {
+    if (const Index *index = d_index.load(std::memory_order_acquire)) {
+      return *index;
+    }
+    std::lock_guard lock(d_mutex);
+    if (!d_owner) {
+      d_owner = std::make_shared<const Index>(build());
+      d_index.store(d_owner.get(), std::memory_order_release);
+    }
+    // `d_owner` keeps the index alive until `reset`.
+    return *d_owner;
+  }
+
+  /// Discard the index so that the next `get` rebuilds it.
+  void reset() {
+    std::lock_guard lock(d_mutex);
+    d_index.store(nullptr, std::memory_order_release);
+    d_owner.reset();
+  }
+
+private:
+  // Read without the mutex; only written with it held.
+  mutable std::atomic<const Index *> d_index{nullptr};
+  // Shared with copies, which keep the index alive after `reset` here.
+  mutable std::shared_ptr<const Index> d_owner;
+  mutable std::mutex d_mutex;
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_LAZY_INDEX_H
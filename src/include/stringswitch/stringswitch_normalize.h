@@ -0,0 +1,180 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_NORMALIZE_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_NORMALIZE_H
+
+#include "stringswitch_hash.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace stringswitch {
+
+// Normalization steps for `NormalizedKey`. A step provides either or both of:
+//
+// * `static constexpr std::string_view trim(std::string_view key)`, narrowing
+//   the key to a substring of itself.
+// * `static constexpr char map(char c)`, replacing every byte of the key.
+//
+// Steps never copy the key: a trim only moves its bounds, and maps are byte
+// to byte, so they are applied as the key is hashed and compared.
+
+/// Drops leading and trailing ASCII whitespace.
+struct TrimWhitespace {
+  static constexpr std::string_view trim(std::string_view key) {
+    constexpr std::string_view k_Whitespace = " \t\n\v\f\r";
+    const std::size_t first = key.find_first_not_of(k_Whitespace);
+    if (first == std::string_view::npos) {
+      return key.substr(key.size());
+    }
+    return key.substr(first, key.find_last_not_of(k_Whitespace) - first + 1);
+  }
+};
+
+/// Drops one pair of matching double or single quotes around the key.
+struct StripQuotes {
+  static constexpr std::string_view trim(std::string_view key) {
+    if (key.size() >= 2 && key.front() == key.back() &&
+        (key.front() == '"' || key.front() == '\'')) {
+      return key.substr(1, key.size() - 2);
+    }
+    return key;
+  }
+};
+
+/// Folds ASCII letters to lower case.
+struct FoldCase {
+  static constexpr char map(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+  }
+};
+
+/// Treats `-`, `_` and `.` as the same separator, stored as `-`.
+struct FoldSeparators {
+  static constexpr char map(char c) { return c == '_' || c == '.' ? '-' : c; }
+};
+
+/// Keys a stringswitch on strings compared after normalization by `Steps`:
+/// all trims, in order, then all maps, in order.
+///
+/// ```cpp
+/// using Lenient = NormalizedKey<TrimWhitespace, StripQuotes, FoldCase,
+///                               FoldSeparators>;
+/// auto switcher = StringSwitch<Format, Lenient>::create()
+///                     .when("utf-8", Format::k_Utf8)
+///                     .on_default(Format::k_Unknown);
+/// switcher.evaluate(" \"UTF_8\" "); // Format::k_Utf8
+/// ```
+///
+/// Labels are stored normalized. Parameters are normalized on the fly, in the
+/// same pass that hashes or compares them, through a table of the composed
+/// maps, so a lookup allocates nothing and reads the parameter once per pass.
+template <class... Steps>
+struct NormalizedKey {
+  using Label = std::string;
+  using Param = std::string_view;
+
+  /// The bounds of `key` after applying the trims of `Steps`.
+  static constexpr std::string_view trim(std::string_view key) {
+    ((key = trim_step<Steps>(key)), ...);
+    return key;
+  }
+
+  /// `c` after applying the maps of `Steps`.
+  static constexpr char map(char c) {
+    return static_cast<char>(k_Map[static_cast<unsigned char>(c)]);
+  }
+
+  // Labels are normalized already, parameters are normalized as they are
+  // read. Both hash the same bytes, so a parameter hashes like its label.
+  struct Hash {
+    using is_transparent = void;
+
+    std::size_t operator()(const Label &label) const {
+      detail::StreamingHash hash;
+      hash.add(label);
+      return hash.value();
+    }
+
+    std::size_t operator()(Param param) const {
+      detail::StreamingHash hash;
+      for (char c : trim(param)) {
+        hash.add(static_cast<unsigned char>(map(c)));
+      }
+      return hash.value();
+    }
+  };
+
+  struct Equal {
+    using is_transparent = void;
+
+    bool operator()(const Label &lhs, const Label &rhs) const {
+      return lhs == rhs;
+    }
+
+    bool operator()(Param param, const Label &label) const {
+      return matches(param, label);
+    }
+
+    bool operator()(const Label &label, Param param) const {
+      return matches(param, label);
+    }
+  };
+
+  static Label own(Param param) {
+    param = trim(param);
+    Label label(param.size(), '\0');
+    for (std::size_t idx = 0; idx != param.size(); ++idx) {
+      label[idx] = map(param[idx]);
+    }
+    return label;
+  }
+
+  static Param view(const Label &label) { return label; }
+
+private:
+  template <class Step>
+  static constexpr std::string_view trim_step(std::string_view key) {
+    if constexpr (requires { Step::trim(key); }) {
+      return Step::trim(key);
+    } else {
+      return key;
+    }
+  }
+
+  template <class Step>
+  static constexpr char map_step(char c) {
+    if constexpr (requires { Step::map(c); }) {
+      return Step::map(c);
+    } else {
+      return c;
+    }
+  }
+
+  static constexpr std::array<unsigned char, 256> k_Map = [] {
+    std::array<unsigned char, 256> table{};
+    for (std::size_t byte = 0; byte != table.size(); ++byte) {
+      char c = static_cast<char>(byte);
+      ((c = map_step<Steps>(c)), ...);
+      table[byte] = static_cast<unsigned char>(c);
+    }
+    return table;
+  }();
+
+  static bool matches(Param param, const Label &label) {
+    param = trim(param);
+    if (param.size() != label.size()) {
+      return false;
+    }
+    for (std::size_t idx = 0; idx != param.size(); ++idx) {
+      if (map(param[idx]) != label[idx]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_NORMALIZE_H
@@ -0,0 +1,98 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_OUTCOME_INDEX_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_OUTCOME_INDEX_H
+
+#include "stringswitch_flat_table.h"
+#include "stringswitch_ranges.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace stringswitch::detail {
+
+/// A type that can key a `std::unordered_map`.
+template <class T>
+concept Hashable = requires(const T &value) {
+  { std::hash<T>{}(value) } -> std::convertible_to<std::size_t>;
+};
+
+/// A dense ordinal for every distinct result of a stringswitch's cases and
+/// ranges, so that bulk operations can index plain arrays by outcome instead
+/// of hashing outcomes once per row.
+///
+/// Ordinals follow the entries of the switch's `FlatTable`, then its range
+/// segments. The outcome of a miss depends on the switch's default rather
+/// than its cases, so callers look it up with `find` instead.
+template <class Result>
+class OutcomeIndex {
+public:
+  OutcomeIndex(const FlatTable<Result> &table,
+               const RangeTable<Result> &ranges) {
+    d_entry_ordinals.reserve(table.size());
+    for (std::size_t entry = 0; entry != table.size(); ++entry) {
+      d_entry_ordinals.push_back(intern(table.result(entry)));
+    }
+    ranges.for_each_segment([this](std::size_t segment, const Result &result) {
+      d_segment_ordinals.resize(segment + 1);
+      d_segment_ordinals[segment] = intern(result);
+    });
+  }
+
+  /// The distinct results, indexed by ordinal.
+  const std::vector<Result> &outcomes() const { return d_outcomes; }
+
+  /// The ordinal of the result of entry `entry` of the flat table.
+  std::size_t entry_ordinal(std::size_t entry) const {
+    return d_entry_ordinals[entry];
+  }
+
+  /// The ordinal of the result of range segment `segment`.
+  std::size_t segment_ordinal(std::size_t segment) const {
+    return d_segment_ordinals[segment];
+  }
+
+  /// The ordinal of `result`, or `outcomes().size()` if no case or range
+  /// produces it.
+  std::size_t find(const Result &result) const {
+    if constexpr (Hashable<Result>) {
+      auto it = d_ordinals.find(result);
+      return it != d_ordinals.end() ? it->second : d_outcomes.size();
+    } else {
+      return static_cast<std::size_t>(
+          std::find(d_outcomes.begin(), d_outcomes.end(), result) -
+          d_outcomes.begin());
+    }
+  }
+
+private:
+  struct NotHashed {};
+
+  std::uint32_t intern(const Result &result) {
+    const std::size_t ordinal = find(result);
+    if (ordinal == d_outcomes.size()) {
+      d_outcomes.push_back(result);
+      if constexpr (Hashable<Result>) {
+        d_ordinals.emplace(result, static_cast<std::uint32_t>(ordinal));
+      }
+    }
+    return static_cast<std::uint32_t>(ordinal);
+  }
+
+  std::vector<std::uint32_t> d_entry_ordinals;
+  std::vector<std::uint32_t> d_segment_ordinals;
+  // Results that can't be hashed are found with a linear search instead.
+  std::conditional_t<Hashable<Result>,
+                     std::unordered_map<Result, std::uint32_t>,
+                     NotHashed>
+      d_ordinals;
+  std::vector<Result> d_outcomes;
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_OUTCOME_INDEX_H
@@ -0,0 +1,144 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_PROBE_TABLE_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_PROBE_TABLE_H
+
+#include "stringswitch_cpu.h"
+#include "stringswitch_hash.h"
+#include "stringswitch_kernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace stringswitch::detail {
+
+/// The first and last eight bytes of a label, overlapping when it is shorter
+/// than 16 bytes. Along with the size, this determines labels of up to
+/// `k_Size` bytes, and longer ones only differ in the bytes in between.
+struct Fingerprint {
+  static constexpr std::size_t k_Size = 16;
+
+  std::uint64_t head;
+  std::uint64_t tail;
+
+  static Fingerprint of(std::string_view label) {
+    if (label.size() >= 8) {
+      return {load_u64(label.data()),
+              load_u64(label.data() + label.size() - 8)};
+    }
+    const ShortKeyWords words = load_short_key(label.data(), label.size());
+    return {words.words[0] | (std::uint64_t{words.words[1]} << 32), 0};
+  }
+
+  bool operator==(const Fingerprint &) const = default;
+};
+
+/// Whether a stored label, the `size` bytes at `data` with fingerprint
+/// `print`, equals `key`, whose fingerprint is `key_print`. Only labels longer
+/// than `Fingerprint::k_Size` read `data`, and then only the bytes the
+/// fingerprints don't cover, with full vector compares and no scalar tail.
+inline bool label_equals(const char *data,
+                         std::size_t size,
+                         const Fingerprint &print,
+                         std::string_view key,
+                         const Fingerprint &key_print,
+                         const Kernels &active) {
+  return size == key.size() && print == key_print &&
+         (size <= Fingerprint::k_Size ||
+          active.equal_bytes(
+              data + 8, key.data() + 8, size - Fingerprint::k_Size));
+}
+
+/// The slots of an open-addressing hash table whose entries are stored
+/// elsewhere, shared by `FlatTable` and `PackedRegistry`.
+///
+/// Slots hold only a 32-bit hash and an entry number, so a probe sequence
+/// usually stays within one cache line, and `find` only asks the caller to
+/// verify an entry once its full hash matches. Probing inspects a group of
+/// slots at a time with the kernels of the active ISA.
+class ProbeTable {
+public:
+  /// Create a table with room for `capacity` entries without rehashing.
+  explicit ProbeTable(std::size_t capacity)
+      : d_slots(std::bit_ceil(std::max<std::size_t>(capacity, 4) * 2) +
+                k_ProbeGroup) {}
+
+  /// Add entry number `entry`, counting from 1, under `hash`.
+  void insert(std::uint32_t hash, std::uint32_t entry) {
+    if ((d_size + 1) * 2 > num_slots()) {
+      rehash(num_slots() * 2);
+    }
+    place(hash, entry);
+    ++d_size;
+  }
+
+  /// Fetch the first slot `hash` probes into the cache.
+  void prefetch(std::uint32_t hash) const {
+    __builtin_prefetch(&d_slots[hash & mask()]);
+  }
+
+  /// The first entry under `hash` for which `matches(entry)` holds, or zero
+  /// if there is none.
+  template <class Matches>
+  std::uint32_t
+  find(std::uint32_t hash, const Kernels &active, Matches &&matches) const {
+    std::size_t pos = hash & mask();
+    for (;;) {
+      const ProbeMasks masks = active.probe_group(&d_slots[pos], hash);
+      // Slots past the first free one belong to other probe sequences.
+      std::uint32_t candidates = masks.matches;
+      if (masks.empties != 0) {
+        candidates &= (masks.empties & (0u - masks.empties)) - 1;
+      }
+      for (; candidates != 0; candidates &= candidates - 1) {
+        const std::uint32_t entry =
+            d_slots[pos + std::countr_zero(candidates)].entry;
+        if (matches(entry)) {
+          return entry;
+        }
+      }
+      if (masks.empties != 0) {
+        return 0;
+      }
+      pos = (pos + k_ProbeGroup) & mask();
+    }
+  }
+
+private:
+  // `d_slots` holds `num_slots()` slots followed by a copy of the first
+  // `k_ProbeGroup`, so that a group starting near the end can be read without
+  // wrapping around.
+  std::size_t num_slots() const { return d_slots.size() - k_ProbeGroup; }
+
+  std::size_t mask() const { return num_slots() - 1; }
+
+  void place(std::uint32_t hash, std::uint32_t entry) {
+    std::size_t pos = hash & mask();
+    while (d_slots[pos].entry != 0) {
+      pos = (pos + 1) & mask();
+    }
+    d_slots[pos] = {hash, entry};
+    if (pos < k_ProbeGroup) {
+      d_slots[num_slots() + pos] = d_slots[pos];
+    }
+  }
+
+  void rehash(std::size_t num_slots) {
+    std::vector<HashSlot> old = std::move(d_slots);
+    d_slots.assign(num_slots + k_ProbeGroup, HashSlot{});
+    for (std::size_t pos = 0; pos + k_ProbeGroup != old.size(); ++pos) {
+      if (old[pos].entry != 0) {
+        place(old[pos].hash, old[pos].entry);
+      }
+    }
+  }
+
+  std::vector<HashSlot> d_slots;
+  std::size_t d_size = 0;
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_PROBE_TABLE_H
@@ -0,0 +1,208 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_RANGES_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_RANGES_H
+
+#include "stringswitch_cpu.h"
+#include "stringswitch_kernels.h"
+#include "stringswitch_lazy_index.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stringswitch::detail {
+
+/// The first 8 bytes of `value` as a big-endian integer, padded with zeros, so
+/// that comparing prefixes agrees with comparing strings whenever the
+/// prefixes differ.
+inline std::uint64_t order_prefix(std::string_view value) {
+  std::uint64_t prefix = 0;
+  const std::size_t size = std::min<std::size_t>(value.size(), 8);
+  for (std::size_t idx = 0; idx != size; ++idx) {
+    prefix |= static_cast<std::uint64_t>(static_cast<unsigned char>(value[idx]))
+              << (56 - 8 * idx);
+  }
+  return prefix;
+}
+
+/// A set of non-overlapping, half-open lexicographic ranges of strings, each
+/// mapped to a result.
+///
+/// The ranges are kept sorted as they are added, and compiled on the first
+/// lookup after a change into a sorted array of boundaries, where each
+/// boundary starts a segment that either maps to a result or is a gap, so
+/// adding n ranges compiles them once rather than n times. A lookup finds
+/// the last boundary not greater than the key: a branchless
+/// binary search over the boundaries' 8-byte prefixes narrows it down to one
+/// block of prefixes, which is counted with a vector compare. Full strings
+/// are only compared among boundaries sharing the key's prefix.
+template <class Result>
+class RangeTable {
+public:
+  /// Sentinel segment returned by `find_segment` for keys in no range.
+  static constexpr std::size_t k_NoSegment = SIZE_MAX;
+
+  bool empty() const { return d_ranges.empty(); }
+
+  /// Map the strings in `[lower, upper)` to `result`, or all strings not less
+  /// than `lower` if `upper` is empty.
+  ///
+  /// Throws `std::invalid_argument` if the range is empty or overlaps a range
+  /// added before.
+  void add(std::string_view lower,
+           std::optional<std::string_view> upper,
+           Result result) {
+    if (upper && *upper <= lower) {
+      throw std::invalid_argument("stringswitch: empty range");
+    }
+    auto next = std::upper_bound(
+        d_ranges.begin(), d_ranges.end(), lower, [](auto key, const auto &r) {
+          return key < r.lower;
+        });
+    const bool overlaps_next =
+        next != d_ranges.end() && (!upper || next->lower < *upper);
+    const bool overlaps_prev =
+        next != d_ranges.begin() &&
+        (!std::prev(next)->upper || lower < *std::prev(next)->upper);
+    if (overlaps_next || overlaps_prev) {
+      throw std::invalid_argument("stringswitch: overlapping ranges");
+    }
+    d_ranges.insert(next,
+                    {std::string(lower),
+                     upper ? std::optional<std::string>(*upper) : std::nullopt,
+                     std::move(result)});
+    d_segments.reset();
+  }
+
+  /// The segment containing `key`, or `k_NoSegment`.
+  std::size_t find_segment(std::string_view key) const {
+    if (d_ranges.empty()) {
+      return k_NoSegment;
+    }
+    const Segments &segments = compiled();
+    const std::uint64_t prefix = order_prefix(key);
+    // Boundaries in [lower, upper) share the key's prefix; the ones before
+    // are smaller than the key and the ones after are greater.
+    const std::size_t lower = segments.count_prefixes_below(prefix);
+    const std::size_t upper = prefix == UINT64_MAX
+                                  ? segments.boundaries.size()
+                                  : segments.count_prefixes_below(prefix + 1);
+    const std::size_t not_greater = static_cast<std::size_t>(
+        std::upper_bound(segments.boundaries.begin() + lower,
+                         segments.boundaries.begin() + upper,
+                         key) -
+        segments.boundaries.begin());
+    if (not_greater == 0 || !segments.outcomes[not_greater - 1]) {
+      return k_NoSegment;
+    }
+    return not_greater - 1;
+  }
+
+  /// The result of `segment`, which must have been returned by
+  /// `find_segment` since the last `add`.
+  const Result &segment_result(std::size_t segment) const {
+    return *compiled().outcomes[segment];
+  }
+
+  /// The result of the range containing `key`, or `nullptr`.
+  const Result *find(std::string_view key) const {
+    const std::size_t segment = find_segment(key);
+    return segment == k_NoSegment ? nullptr : &segment_result(segment);
+  }
+
+  /// Invoke `visit(segment, result)` for every segment that maps to a result.
+  template <class Visitor>
+  void for_each_segment(Visitor &&visit) const {
+    if (d_ranges.empty()) {
+      return;
+    }
+    const Segments &segments = compiled();
+    for (std::size_t idx = 0; idx != segments.outcomes.size(); ++idx) {
+      if (segments.outcomes[idx]) {
+        visit(idx, *segments.outcomes[idx]);
+      }
+    }
+  }
+
+private:
+  struct Range {
+    std::string lower;
+    std::optional<std::string> upper;
+    Result result;
+  };
+
+  // The ranges compiled for lookups.
+  struct Segments {
+    std::vector<std::string> boundaries;
+    // `outcomes[idx]` applies to keys in [boundaries[idx],
+    // boundaries[idx + 1]); an empty outcome marks a gap between ranges.
+    std::vector<std::optional<Result>> outcomes;
+    std::vector<std::uint64_t> prefixes;
+
+    // The number of boundaries whose prefix is less than `prefix`.
+    std::size_t count_prefixes_below(std::uint64_t prefix) const {
+      // Find the last block whose first prefix is below `prefix` (or the
+      // first block). Every block before it is entirely below `prefix`, and
+      // every block after it entirely above, so only that block needs
+      // counting.
+      std::size_t block = 0;
+      std::size_t remaining = prefixes.size() / k_CountBlock;
+      while (remaining > 1) {
+        const std::size_t half = remaining / 2;
+        block = prefixes[(block + half) * k_CountBlock] < prefix ? block + half
+                                                                 : block;
+        remaining -= half;
+      }
+      const std::size_t count =
+          block * k_CountBlock +
+          kernels().count_below(&prefixes[block * k_CountBlock], prefix);
+      return std::min(count, boundaries.size());
+    }
+  };
+
+  const Segments &compiled() const {
+    return d_segments.get([this] { return compile(); });
+  }
+
+  // Build the boundary arrays from `d_ranges`.
+  Segments compile() const {
+    Segments segments;
+    for (const Range &range : d_ranges) {
+      if (!segments.boundaries.empty() &&
+          segments.boundaries.back() == range.lower) {
+        // The previous range ends where this one starts: no gap.
+        segments.outcomes.back() = range.result;
+      } else {
+        segments.boundaries.push_back(range.lower);
+        segments.outcomes.push_back(range.result);
+      }
+      if (range.upper) {
+        segments.boundaries.push_back(*range.upper);
+        segments.outcomes.push_back(std::nullopt);
+      }
+    }
+    segments.prefixes.reserve(segments.boundaries.size() + k_CountBlock);
+    for (const std::string &boundary : segments.boundaries) {
+      segments.prefixes.push_back(order_prefix(boundary));
+    }
+    // Pad to whole blocks; the padding is never below any key.
+    segments.prefixes.resize(
+        (segments.prefixes.size() + k_CountBlock - 1) / k_CountBlock *
+            k_CountBlock,
+        UINT64_MAX);
+    return segments;
+  }
+
+  // Sorted by lower bound.
+  std::vector<Range> d_ranges;
+  // Compiled from `d_ranges` on first use.
+  LazyIndex<Segments> d_segments;
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_RANGES_H
@@ -0,0 +1,196 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_REGISTRY_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_REGISTRY_H
+
+#include "stringswitch_cpu.h"
+#include "stringswitch_extras.h"
+#include "stringswitch_hash.h"
+#include "stringswitch_impl.h"
+#include "stringswitch_kernels.h"
+#include "stringswitch_probe_table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace stringswitch {
+
+template <class Result>
+class PackedRegistry;
+
+/// A stringswitch frozen into a `PackedRegistry`: a registry and an id. It is
+/// cheap to copy and valid as long as the registry is.
+template <class Result, bool default_given>
+class PackedSwitch {
+public:
+  using EffectiveResultType =
+      std::conditional_t<default_given, Result, std::optional<Result>>;
+
+  EffectiveResultType evaluate(std::string_view param) const {
+    if (const Result *found = d_registry->find(d_id, param)) {
+      return *found;
+    }
+    if constexpr (default_given) {
+      return *d_registry->default_result(d_id);
+    } else {
+      return std::nullopt;
+    }
+  }
+
+private:
+  friend class PackedRegistry<Result>;
+
+  PackedSwitch(const PackedRegistry<Result> &registry, std::uint32_t id)
+      : d_registry(&registry), d_id(id) {}
+
+  const PackedRegistry<Result> *d_registry;
+  std::uint32_t d_id;
+};
+
+/// One table holding the cases of many small stringswitches, for programs
+/// with thousands of them.
+///
+/// A stringswitch owns a hash map, with a bucket array and a node per case,
+/// and carries that overhead however few cases it has. A registry instead
+/// keeps the labels of every switch added to it in one arena, their results
+/// in one array, and one open-addressing table keyed by (switch id, label),
+/// so memory and cache footprint grow with the number of labels rather than
+/// the number of switches.
+///
+/// A registry is built on one thread, then frozen and shared: `add` moves
+/// the table, so it must not run concurrently with lookups, and `freeze`
+/// makes any later `add` throw. A frozen registry is never modified, and its
+/// switches may be evaluated from any number of threads.
+///
+/// ```cpp
+/// PackedRegistry<Unit> registry;
+/// const auto units = registry.add(StringSwitch<Unit>::create()
+///                                     .when("ms", Unit::k_Millis)
+///                                     .when("s", Unit::k_Seconds)
+///                                     .on_default(Unit::k_Unknown));
+/// // ... add the program's other switches ...
+/// registry.freeze();
+/// units.evaluate("ms"); // Unit::k_Millis
+/// ```
+///
+/// Switches are copied when added: later changes to the original are not
+/// seen. Ranges are not supported.
+template <class Result>
+class PackedRegistry {
+public:
+  PackedRegistry() : d_slots(k_MinCapacity) {}
+
+  PackedRegistry(const PackedRegistry &) = delete;
+  PackedRegistry &operator=(const PackedRegistry &) = delete;
+
+  /// Copy the cases and default of `sw` into the registry. Throws
+  /// `std::invalid_argument` if `sw` has ranges, and `std::logic_error` if
+  /// the registry is frozen.
+  template <detail::LateBoundSwitch Switch>
+  requires std::same_as<typename Switch::ResultType, Result>
+  auto add(const Switch &sw) {
+    constexpr bool k_DefaultGiven =
+        std::is_same_v<typename Switch::EffectiveResultType, Result>;
+    if (d_frozen) {
+      throw std::logic_error("stringswitch: packed registry is frozen");
+    }
+    if (detail::SwitchAccess::has_ranges(sw)) {
+      throw std::invalid_argument(
+          "stringswitch: packed switches do not support ranges");
+    }
+    const auto id = static_cast<std::uint32_t>(d_defaults.size());
+    if constexpr (k_DefaultGiven) {
+      d_defaults.emplace_back(detail::SwitchAccess::on_miss(sw));
+    } else {
+      d_defaults.emplace_back();
+    }
+    detail::SwitchAccess::for_each_case(
+        sw, [&](std::string_view label, const Result &result) {
+          insert(id, label, result);
+        });
+    return PackedSwitch<Result, k_DefaultGiven>(*this, id);
+  }
+
+  /// End the build phase: the registry may be shared between threads from
+  /// now on, and `add` throws.
+  void freeze() { d_frozen = true; }
+
+  /// The number of switches added.
+  std::size_t num_switches() const { return d_defaults.size(); }
+
+  /// The number of cases over all switches.
+  std::size_t size() const { return d_entries.size(); }
+
+  /// The result of switch `id` for `param`, or `nullptr` if it has no case
+  /// for it.
+  const Result *find(std::uint32_t id, std::string_view param) const {
+    const detail::Kernels &active = detail::kernels();
+    const detail::Fingerprint print = detail::Fingerprint::of(param);
+    const std::uint32_t found =
+        d_slots.find(hash(id, param), active, [&](std::uint32_t entry) {
+          const Entry &candidate = d_entries[entry - 1];
+          return candidate.id == id &&
+                 detail::label_equals(d_labels.data() + candidate.offset,
+                                      candidate.size,
+                                      candidate.fingerprint,
+                                      param,
+                                      print,
+                                      active);
+        });
+    return found != 0 ? &d_entries[found - 1].result : nullptr;
+  }
+
+  /// The default of switch `id`, if it has one.
+  const std::optional<Result> &default_result(std::uint32_t id) const {
+    return d_defaults[id];
+  }
+
+private:
+  static constexpr std::size_t k_MinCapacity = 32;
+
+  // The label is the `size` bytes at `offset` in `d_labels`.
+  struct Entry {
+    std::uint32_t id;
+    std::uint32_t offset;
+    std::uint32_t size;
+    detail::Fingerprint fingerprint;
+    Result result;
+  };
+
+  static std::uint32_t hash(std::uint32_t id, std::string_view label) {
+    return detail::hash_finalize(detail::hash_bytes(label) ^
+                                 (id * detail::k_HashWordMul[0]));
+  }
+
+  void insert(std::uint32_t id, std::string_view label, const Result &result) {
+    if (d_labels.size() + label.size() >
+        std::numeric_limits<std::uint32_t>::max()) {
+      throw std::length_error("stringswitch: packed registry is full");
+    }
+    d_entries.push_back({id,
+                         static_cast<std::uint32_t>(d_labels.size()),
+                         static_cast<std::uint32_t>(label.size()),
+                         detail::Fingerprint::of(label),
+                         result});
+    d_labels.append(label);
+    d_slots.insert(hash(id, label),
+                   static_cast<std::uint32_t>(d_entries.size()));
+  }
+
+  detail::ProbeTable d_slots;
+  std::vector<Entry> d_entries;
+  // The labels of every entry, back to back.
+  std::string d_labels;
+  // Indexed by switch id.
+  std::vector<std::optional<Result>> d_defaults;
+  bool d_frozen = false;
+};
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_REGISTRY_H
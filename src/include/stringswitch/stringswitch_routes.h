@@ -0,0 +1,253 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_ROUTES_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_ROUTES_H
+
+#include "stringswitch_cpu.h"
+#include "stringswitch_flat_table.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stringswitch {
+
+/// The most captures (`{name}` segments plus a trailing `*`) a route may have.
+inline constexpr std::size_t k_MaxRouteCaptures = 8;
+
+/// A successful `RouteSwitch::match`: the result of the matched route and the
+/// parts of the path its captures matched.
+///
+/// The captures point into the matched path and the names into the switch, so
+/// a match must not outlive either.
+template <class Result>
+class RouteMatch {
+public:
+  const Result &result() const { return *d_result; }
+
+  std::size_t num_captures() const { return d_num_captures; }
+
+  /// The part of the path matched by the `idx`-th capture of the route, in
+  /// pattern order.
+  std::string_view capture(std::size_t idx) const { return d_captures[idx]; }
+
+  /// The part of the path matched by the capture called `name` (`*` for a
+  /// trailing wildcard), if the route has one.
+  std::optional<std::string_view> capture(std::string_view name) const {
+    for (std::size_t idx = 0; idx != d_num_captures; ++idx) {
+      if ((*d_names)[idx] == name) {
+        return d_captures[idx];
+      }
+    }
+    return std::nullopt;
+  }
+
+private:
+  template <class>
+  friend class RouteSwitch;
+
+  const Result *d_result = nullptr;
+  const std::vector<std::string> *d_names = nullptr;
+  std::array<std::string_view, k_MaxRouteCaptures> d_captures;
+  std::size_t d_num_captures = 0;
+};
+
+/// Dispatches `/`-separated paths to results over a tree of routes.
+///
+/// A route pattern is a sequence of segments separated by `/`, each of which
+/// is one of:
+///
+/// * a literal, which matches exactly that segment,
+/// * `{name}`, which captures any non-empty segment,
+/// * `*`, only as the last segment, which captures the rest of the path
+///   (possibly empty, and possibly spanning several segments).
+///
+/// ```cpp
+/// auto routes = stringswitch::RouteSwitch<Handler>()
+///                   .when("/users/{id}", Handler::k_User)
+///                   .when("/users/{id}/posts", Handler::k_Posts)
+///                   .when("/static/*", Handler::k_Static);
+/// if (auto match = routes.match("/users/42/posts")) {
+///   // match->result() == Handler::k_Posts, match->capture("id") == "42"
+/// }
+/// ```
+///
+/// When several routes match a path, literals take priority over captures,
+/// which take priority over wildcards, segment by segment from the left: a
+/// less specific alternative is only tried when the more specific one fails
+/// to match the rest of the path.
+///
+/// Each node of the tree looks its literal children up in a `FlatTable`, and
+/// routes without captures are additionally indexed by their whole path.
+/// Matching splits the path as it walks the tree, using the active ISA's byte
+/// search, and never allocates.
+template <class Result>
+class RouteSwitch {
+public:
+  RouteSwitch() : d_nodes(1), d_static_routes(0) {}
+
+  /// Route paths matching `pattern` to `result`.
+  ///
+  /// Throws `std::invalid_argument` if the pattern is malformed, has more than
+  /// `k_MaxRouteCaptures` captures, or matches the same paths as a route
+  /// added before.
+  RouteSwitch &when(std::string_view pattern, Result result) {
+    std::vector<std::string> names;
+    std::uint32_t node = 0;
+    bool is_static = true;
+    bool wildcard = false;
+    for (std::size_t pos = 0; pos <= pattern.size();) {
+      const std::size_t end = std::min(pattern.find('/', pos), pattern.size());
+      const std::string_view segment = pattern.substr(pos, end - pos);
+      pos = end + 1;
+      if (wildcard) {
+        throw std::invalid_argument(
+            "stringswitch: `*` must be the last segment of a route");
+      }
+      const bool is_capture = segment == "*" || (segment.starts_with('{') &&
+                                                 segment.ends_with('}') &&
+                                                 segment.size() > 2);
+      // Checked before descending, so that matching never visits a node
+      // deeper than `k_MaxRouteCaptures` captures.
+      if (is_capture && names.size() == k_MaxRouteCaptures) {
+        throw std::invalid_argument("stringswitch: too many route captures");
+      }
+      if (segment == "*") {
+        names.emplace_back("*");
+        is_static = false;
+        wildcard = true;
+      } else if (is_capture) {
+        names.emplace_back(segment.substr(1, segment.size() - 2));
+        is_static = false;
+        node = capture_child(node);
+      } else if (segment.find_first_of("{}*") != std::string_view::npos) {
+        throw std::invalid_argument("stringswitch: malformed route segment");
+      } else {
+        node = literal_child(node, segment);
+      }
+    }
+
+    std::uint32_t &slot =
+        wildcard ? d_nodes[node].wildcard_route : d_nodes[node].route;
+    if (slot != k_None) {
+      throw std::invalid_argument("stringswitch: duplicate route");
+    }
+    slot = static_cast<std::uint32_t>(d_routes.size());
+    if (is_static) {
+      d_static_routes.insert(pattern, slot);
+    }
+    d_routes.push_back({std::move(result), std::move(names)});
+    return *this;
+  }
+
+  /// The route matching `path` and its captures, if any route matches.
+  std::optional<RouteMatch<Result>> match(std::string_view path) const {
+    RouteMatch<Result> found;
+    if (const std::uint32_t *route = d_static_routes.find(path)) {
+      bind(found, *route);
+      return found;
+    }
+    if (match_from(0, path, 0, found)) {
+      return found;
+    }
+    return std::nullopt;
+  }
+
+private:
+  static constexpr std::uint32_t k_None = UINT32_MAX;
+
+  struct Route {
+    Result result;
+    std::vector<std::string> names;
+  };
+
+  struct Node {
+    // Children reached through a literal segment.
+    detail::FlatTable<std::uint32_t> literals{0};
+    // Child reached through a `{name}` segment.
+    std::uint32_t capture = k_None;
+    // Route ending at this node.
+    std::uint32_t route = k_None;
+    // Route ending at this node with a `*` segment.
+    std::uint32_t wildcard_route = k_None;
+  };
+
+  std::uint32_t literal_child(std::uint32_t node, std::string_view segment) {
+    if (const std::uint32_t *child = d_nodes[node].literals.find(segment)) {
+      return *child;
+    }
+    const auto child = static_cast<std::uint32_t>(d_nodes.size());
+    d_nodes.emplace_back();
+    d_nodes[node].literals.insert(segment, child);
+    return child;
+  }
+
+  std::uint32_t capture_child(std::uint32_t node) {
+    if (d_nodes[node].capture == k_None) {
+      d_nodes[node].capture = static_cast<std::uint32_t>(d_nodes.size());
+      d_nodes.emplace_back();
+    }
+    return d_nodes[node].capture;
+  }
+
+  void bind(RouteMatch<Result> &found, std::uint32_t route) const {
+    found.d_result = &d_routes[route].result;
+    found.d_names = &d_routes[route].names;
+  }
+
+  // Match the part of `path` starting at `pos` against the subtree under
+  // `node`. `pos` is one past the end of `path` once every segment has been
+  // consumed.
+  bool match_from(std::uint32_t node_idx,
+                  std::string_view path,
+                  std::size_t pos,
+                  RouteMatch<Result> &found) const {
+    const Node &node = d_nodes[node_idx];
+    if (pos > path.size()) {
+      if (node.route == k_None) {
+        return false;
+      }
+      bind(found, node.route);
+      return true;
+    }
+
+    const std::size_t end =
+        pos +
+        detail::kernels().find_byte(path.data() + pos, path.size() - pos, '/');
+    const std::string_view segment = path.substr(pos, end - pos);
+    if (const std::uint32_t *child = node.literals.find(segment)) {
+      if (match_from(*child, path, end + 1, found)) {
+        return true;
+      }
+    }
+    if (node.capture != k_None && !segment.empty()) {
+      const std::size_t num_captures = found.d_num_captures;
+      found.d_captures[num_captures] = segment;
+      found.d_num_captures = num_captures + 1;
+      if (match_from(node.capture, path, end + 1, found)) {
+        return true;
+      }
+      found.d_num_captures = num_captures;
+    }
+    if (node.wildcard_route != k_None) {
+      found.d_captures[found.d_num_captures++] = path.substr(pos);
+      bind(found, node.wildcard_route);
+      return true;
+    }
+    return false;
+  }
+
+  // `d_nodes[0]` is the root.
+  std::vector<Node> d_nodes;
+  std::vector<Route> d_routes;
+  // Routes without captures, keyed by their whole pattern.
+  detail::FlatTable<std::uint32_t> d_static_routes;
+};
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_ROUTES_H
@@ -0,0 +1,160 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_SHARED_EXTRAS_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_SHARED_EXTRAS_H
+
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+
+namespace stringswitch::detail {
+
+// The indexes a switch can build over its cases. Each is defined in its own
+// header, which only the features using it include.
+template <class Result>
+class FlatTable;
+template <class Result>
+class SortedTable;
+template <class Result>
+class RangeTable;
+template <class Result>
+class CompletionIndex;
+template <class Result>
+class OutcomeIndex;
+class SuggestionTrie;
+
+// Ranges, weights, and indexes of a switch, see stringswitch_extras.h.
+template <class Result, class Key>
+struct SwitchExtras;
+
+template <class Result>
+class SharedExtras;
+
+/// What a switch needs of its `SwitchExtras` to hold, copy, and consult
+/// them, so that the switch itself compiles without the headers defining
+/// them.
+template <class Result>
+class SwitchExtrasBase {
+public:
+  virtual ~SwitchExtrasBase() = default;
+
+  /// A copy of these extras, for a switch about to modify extras it shares.
+  virtual SwitchExtrasBase *clone() const = 0;
+
+  /// Discard the indexes derived from the cases, after they changed.
+  virtual void reset_indexes() = 0;
+
+  /// The result of the range containing `param`, or `nullptr`.
+  virtual const Result *find_range(std::string_view param) const = 0;
+
+protected:
+  SwitchExtrasBase() = default;
+
+  // A copy starts out unshared.
+  SwitchExtrasBase(const SwitchExtrasBase &) {}
+
+  SwitchExtrasBase &operator=(const SwitchExtrasBase &) = delete;
+
+private:
+  friend class SharedExtras<Result>;
+
+  mutable std::atomic<std::size_t> d_references{1};
+};
+
+/// A single pointer to the extras of a switch, allocated on first use and
+/// shared by copies of the switch until one of them modifies them.
+///
+/// `find`, `get`, and copying may be called concurrently: `get` allocates
+/// with a compare-and-swap, so concurrent first calls agree on one object.
+/// `modify` copies shared extras first, and is not safe to call concurrently
+/// with anything else on the same pointer.
+///
+/// Only `get` and `modify` name the concrete `Extras`, which must derive
+/// from `SwitchExtrasBase<Result>`; the rest goes through the base.
+template <class Result>
+class SharedExtras {
+public:
+  using Base = SwitchExtrasBase<Result>;
+
+  SharedExtras() = default;
+
+  SharedExtras(const SharedExtras &other) : d_node(other.acquire()) {}
+
+  SharedExtras(SharedExtras &&other) noexcept
+      : d_node(other.d_node.exchange(nullptr, std::memory_order_relaxed)) {}
+
+  SharedExtras &operator=(SharedExtras other) noexcept {
+    Base *node = other.d_node.exchange(nullptr, std::memory_order_relaxed);
+    release(d_node.exchange(node, std::memory_order_acq_rel));
+    return *this;
+  }
+
+  ~SharedExtras() { release(d_node.load(std::memory_order_acquire)); }
+
+  /// The extras, or null if none were allocated yet.
+  const Base *find() const { return d_node.load(std::memory_order_acquire); }
+
+  /// The extras, allocating them if needed.
+  template <class Extras>
+  const Extras &get() const {
+    Base *node = d_node.load(std::memory_order_acquire);
+    if (node == nullptr) {
+      Base *created = new Extras();
+      if (d_node.compare_exchange_strong(node,
+                                         created,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+        node = created;
+      } else {
+        delete created;
+      }
+    }
+    return static_cast<const Extras &>(*node);
+  }
+
+  /// The extras for modification, copied first if another pointer shares
+  /// them, or null if none were allocated yet.
+  Base *modify_existing() {
+    Base *node = d_node.load(std::memory_order_acquire);
+    if (node != nullptr &&
+        node->d_references.load(std::memory_order_acquire) != 1) {
+      Base *copy = node->clone();
+      release(node);
+      node = copy;
+      d_node.store(node, std::memory_order_release);
+    }
+    return node;
+  }
+
+  /// The extras for modification, allocated if needed, and copied first if
+  /// another pointer shares them.
+  template <class Extras>
+  Extras &modify() {
+    Base *node = modify_existing();
+    if (node == nullptr) {
+      node = new Extras();
+      d_node.store(node, std::memory_order_release);
+    }
+    return static_cast<Extras &>(*node);
+  }
+
+private:
+  Base *acquire() const {
+    Base *node = d_node.load(std::memory_order_acquire);
+    if (node != nullptr) {
+      node->d_references.fetch_add(1, std::memory_order_relaxed);
+    }
+    return node;
+  }
+
+  static void release(Base *node) {
+    if (node != nullptr &&
+        node->d_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete node;
+    }
+  }
+
+  mutable std::atomic<Base *> d_node{nullptr};
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_SHARED_EXTRAS_H
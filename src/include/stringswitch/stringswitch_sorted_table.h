@@ -0,0 +1,92 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_SORTED_TABLE_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_SORTED_TABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stringswitch::detail {
+
+/// An immutable array of labels in lexicographic order with their results,
+/// used to join a sorted batch against a stringswitch's cases.
+///
+/// The labels are kept back to back in one arena, in the same order as the
+/// entries, so walking the table front to back reads memory sequentially.
+/// `lower_bound_from` searches forwards from a cursor by galloping: it probes
+/// 1, 2, 4, ... entries ahead, then binary searches the last step, so a key
+/// `d` entries past the cursor costs O(log d) comparisons that all fall near
+/// the cursor, rather than O(log n) scattered over the whole table.
+template <class Result>
+class SortedTable {
+public:
+  struct Case {
+    std::string_view label;
+    Result result;
+  };
+
+  /// Sort `cases`, whose labels must be distinct, and copy them in.
+  explicit SortedTable(std::vector<Case> cases) {
+    std::sort(cases.begin(), cases.end(), [](const Case &lhs, const Case &rhs) {
+      return lhs.label < rhs.label;
+    });
+    std::size_t total = 0;
+    for (const Case &c : cases) {
+      total += c.label.size();
+    }
+    d_labels.reserve(total);
+    d_entries.reserve(cases.size());
+    for (Case &c : cases) {
+      d_entries.push_back(
+          {d_labels.size(), c.label.size(), std::move(c.result)});
+      d_labels.append(c.label);
+    }
+  }
+
+  std::size_t size() const { return d_entries.size(); }
+
+  std::string_view label(std::size_t pos) const {
+    return {d_labels.data() + d_entries[pos].offset, d_entries[pos].size};
+  }
+
+  const Result &result(std::size_t pos) const { return d_entries[pos].result; }
+
+  /// The first position at or after `from` whose label is not less than
+  /// `key`, or `size()` if there is none. Every label before `from` must be
+  /// less than `key`.
+  std::size_t lower_bound_from(std::size_t from, std::string_view key) const {
+    std::size_t low = from;
+    std::size_t probe = from;
+    for (std::size_t step = 1; probe < size() && label(probe) < key;
+         step *= 2) {
+      low = probe + 1;
+      probe += step;
+    }
+    std::size_t high = std::min(probe, size());
+    while (low != high) {
+      const std::size_t mid = low + (high - low) / 2;
+      if (label(mid) < key) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return low;
+  }
+
+private:
+  // The label is the `size` bytes at `offset` in `d_labels`.
+  struct Entry {
+    std::size_t offset;
+    std::size_t size;
+    Result result;
+  };
+
+  std::vector<Entry> d_entries;
+  std::string d_labels;
+};
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_SORTED_TABLE_H
@@ -0,0 +1,202 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_SUGGEST_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_SUGGEST_H
+
+#include "stringswitch_extras.h"
+#include "stringswitch_impl.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stringswitch {
+
+namespace detail {
+
+/// A trie over a set of labels, answering nearest-label queries under
+/// Levenshtein distance.
+///
+/// A query walks the trie depth first, keeping one row of the edit distance
+/// matrix per depth: the row of a node extends its parent's by the node's
+/// byte, so labels sharing a prefix share its rows. This simulates a
+/// Levenshtein automaton for the query over the trie. A subtree is skipped as
+/// soon as no entry of its row is below the best distance found so far, which
+/// bounds the walk to prefixes within reach of the query.
+class SuggestionTrie {
+public:
+  /// Index `labels`, which must be distinct.
+  explicit SuggestionTrie(std::vector<std::string> labels)
+      : d_labels(std::move(labels)) {
+    std::sort(d_labels.begin(), d_labels.end());
+    for (const std::string &label : d_labels) {
+      d_longest_label = std::max(d_longest_label, label.size());
+    }
+    d_nodes.push_back({});
+    build(0, 0, d_labels.size(), 0);
+  }
+
+  /// The label closest to `query`, if any is within `max_distance`. Ties go to
+  /// the lexicographically smallest label.
+  std::optional<Suggestion> nearest(std::string_view query,
+                                    std::size_t max_distance) const {
+    // Every label is within this of the query, so larger limits (such as
+    // `SIZE_MAX` for "any distance") mean the same and would only overflow
+    // the sizes below.
+    max_distance =
+        std::min(max_distance, std::max(query.size(), d_longest_label));
+    Search search{query, 0, {}, std::nullopt};
+    // No label more than `query.size() + max_distance` bytes deep is within
+    // reach, so that bounds the rows ever needed.
+    search.rows.resize((query.size() + max_distance + 2) * (query.size() + 1));
+    for (std::size_t idx = 0; idx <= query.size(); ++idx) {
+      search.rows[idx] = static_cast<std::uint32_t>(idx);
+    }
+    // Widen the search one edit at a time. A walk with a small limit prunes
+    // almost everything, so when a close label exists this is much cheaper
+    // than a single walk with the full limit, and otherwise it costs about
+    // as much again as the last walk.
+    for (std::size_t limit = 1; limit <= max_distance + 1 && !search.best;
+         ++limit) {
+      search.limit = limit;
+      visit(0, 0, search);
+    }
+    return search.best;
+  }
+
+private:
+  static constexpr std::uint32_t k_NoLabel = UINT32_MAX;
+
+  struct Node {
+    // Children occupy `d_nodes[first_child, first_child + num_children)`,
+    // ordered by byte.
+    std::uint32_t first_child = 0;
+    std::uint32_t num_children = 0;
+    // The label ending at this node, as an index into `d_labels`.
+    std::uint32_t label = k_NoLabel;
+    char byte = 0;
+  };
+
+  struct Search {
+    std::string_view query;
+    // Only labels closer than this are of interest.
+    std::size_t limit;
+    // Row `depth` of the edit distance matrix is
+    // `rows[depth * (query.size() + 1), (depth + 1) * (query.size() + 1))`.
+    std::vector<std::uint32_t> rows;
+    std::optional<Suggestion> best;
+  };
+
+  // Fill in `d_nodes[node]` for the labels in `d_labels[lo, hi)`, which share
+  // their first `depth` bytes.
+  void build(std::uint32_t node, std::size_t lo, std::size_t hi,
+             std::size_t depth) {
+    if (lo != hi && d_labels[lo].size() == depth) {
+      d_nodes[node].label = static_cast<std::uint32_t>(lo++);
+    }
+    // Allocate the children together, then fill them in.
+    std::vector<std::size_t> bounds;
+    for (std::size_t idx = lo; idx != hi; ++idx) {
+      if (idx == lo || d_labels[idx][depth] != d_labels[idx - 1][depth]) {
+        bounds.push_back(idx);
+      }
+    }
+    bounds.push_back(hi);
+    const auto first_child = static_cast<std::uint32_t>(d_nodes.size());
+    d_nodes[node].first_child = first_child;
+    d_nodes[node].num_children = static_cast<std::uint32_t>(bounds.size() - 1);
+    d_nodes.resize(d_nodes.size() + bounds.size() - 1);
+    for (std::size_t child = 0; child + 1 != bounds.size(); ++child) {
+      d_nodes[first_child + child].byte = d_labels[bounds[child]][depth];
+      build(first_child + static_cast<std::uint32_t>(child),
+            bounds[child],
+            bounds[child + 1],
+            depth + 1);
+    }
+  }
+
+  // Visit the subtree under `node`, whose row at `depth` is filled in.
+  //
+  // Only the band of a row within `limit` of the diagonal is computed: any
+  // entry outside it is at least `limit` anyway. The entries just outside the
+  // band are set to `limit`, so an entry below `limit` is always exact.
+  void visit(std::uint32_t node_idx, std::size_t depth, Search &search) const {
+    const Node &node = d_nodes[node_idx];
+    const std::size_t size = search.query.size();
+    const std::size_t width = size + 1;
+    const std::uint32_t *row = &search.rows[depth * width];
+    const std::size_t skew = size > depth ? size - depth : depth - size;
+    if (node.label != k_NoLabel && skew < search.limit &&
+        row[size] < search.limit) {
+      // Labels are visited in order, so an equally close label found later
+      // never replaces an earlier one.
+      search.best = Suggestion{d_labels[node.label], row[size]};
+      search.limit = row[size];
+    }
+    if (depth + 1 == search.rows.size() / width) {
+      return;
+    }
+    std::uint32_t *next = &search.rows[(depth + 1) * width];
+    for (std::uint32_t child = node.first_child;
+         child != node.first_child + node.num_children && search.limit != 0;
+         ++child) {
+      const auto limit = static_cast<std::uint32_t>(search.limit);
+      const std::size_t lo = depth + 1 >= limit ? depth + 2 - limit : 0;
+      const std::size_t hi = std::min(size, depth + limit);
+      if (lo > hi) {
+        // The prefix is already `limit` bytes longer than the query.
+        continue;
+      }
+      const char byte = d_nodes[child].byte;
+      std::uint32_t lowest = limit;
+      if (lo == 0) {
+        next[0] = static_cast<std::uint32_t>(depth + 1);
+        lowest = next[0];
+      } else {
+        next[lo - 1] = limit;
+      }
+      for (std::size_t idx = std::max<std::size_t>(lo, 1); idx <= hi; ++idx) {
+        const std::uint32_t substitute =
+            row[idx - 1] + (search.query[idx - 1] != byte);
+        const std::uint32_t indel = std::min(row[idx], next[idx - 1]) + 1;
+        next[idx] = std::min(substitute, indel);
+        lowest = std::min(lowest, next[idx]);
+      }
+      if (hi < size) {
+        next[hi + 1] = limit;
+      }
+      if (lowest < limit) {
+        visit(child, depth + 1, search);
+      }
+    }
+  }
+
+  std::vector<std::string> d_labels;
+  std::size_t d_longest_label = 0;
+  // `d_nodes[0]` is the root.
+  std::vector<Node> d_nodes;
+};
+
+// `sw.nearest(param, max_distance)`, indexing the labels of `sw` on the first
+// call.
+template <class Switch>
+std::optional<Suggestion> nearest_case(const Switch &sw,
+                                       std::string_view param,
+                                       std::size_t max_distance) {
+  const SuggestionTrie &trie = SwitchAccess::extras(sw).suggestions.get([&sw] {
+    std::vector<std::string> labels;
+    labels.reserve(SwitchAccess::num_cases(sw));
+    SwitchAccess::for_each_case(sw, [&](std::string_view label, const auto &) {
+      labels.emplace_back(label);
+    });
+    return SuggestionTrie(std::move(labels));
+  });
+  return trie.nearest(param, max_distance);
+}
+
+} // namespace detail
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_SUGGEST_H
@@ -0,0 +1,187 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_TIERED_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_TIERED_H
+
+#include "stringswitch_impl.h"
+#include "stringswitch_jit.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace stringswitch {
+
+/// A stringswitch that starts on its build-fast hash table and moves to a
+/// `CompiledSwitch` once it has proven to be used, the way a JIT compiler
+/// tiers up hot code.
+///
+/// Lookups are counted until `promotion_threshold` is reached. The lookup
+/// that reaches it starts a background thread that compiles the switch,
+/// times both tiers on a sample of the switch's labels, and publishes the
+/// compiled switch with a single atomic store only if it is at least as
+/// fast; lookups carry on from the hash table meanwhile, and read the
+/// compiled switch from then on. Switches used only a few times never pay for
+/// compiling, and promotion never makes lookups slower. A threshold of 0
+/// compiles the switch during construction, as `promote` does.
+///
+/// Counting stops at the threshold, so lookups never write shared state
+/// again, even if compiling fails, the compiled switch is slower, or no
+/// thread could be started to do it; the switch then stays on its hash table
+/// unless `promote` succeeds later.
+///
+/// `evaluate` may be called concurrently. The switch is taken by value, so
+/// pass a temporary or move it in to avoid copying its cases; the destructor
+/// waits for a compilation in progress.
+template <detail::LateBoundSwitch Switch>
+class TieredSwitch {
+public:
+  using EffectiveResultType = typename Switch::EffectiveResultType;
+
+  static constexpr std::size_t k_DefaultPromotionThreshold = 4096;
+
+  explicit TieredSwitch(
+      Switch sw,
+      std::size_t promotion_threshold = k_DefaultPromotionThreshold,
+      JitMode mode = JitMode::k_Auto)
+      : d_switch(std::move(sw)),
+        d_threshold(promotion_threshold),
+        d_mode(mode) {
+    if (d_threshold == 0) {
+      promote();
+    }
+  }
+
+  TieredSwitch(const TieredSwitch &) = delete;
+  TieredSwitch &operator=(const TieredSwitch &) = delete;
+
+  ~TieredSwitch() {
+    std::lock_guard lock(d_builder_mutex);
+    if (d_builder.joinable()) {
+      d_builder.join();
+    }
+  }
+
+  EffectiveResultType evaluate(std::string_view param) const {
+    if (const auto *compiled = d_compiled.load(std::memory_order_acquire)) {
+      return compiled->evaluate(param);
+    }
+    // Past the threshold this is a read of a line nobody writes.
+    if (d_lookups.load(std::memory_order_relaxed) < d_threshold &&
+        d_lookups.fetch_add(1, std::memory_order_relaxed) + 1 == d_threshold) {
+      start_promotion();
+    }
+    return d_switch.evaluate(param);
+  }
+
+  /// Whether lookups use the compiled switch.
+  bool is_promoted() const {
+    return d_compiled.load(std::memory_order_acquire) != nullptr;
+  }
+
+  /// Compile the switch now, on the calling thread, after waiting for the
+  /// background compilation if it has started, and use it whether or not it
+  /// is faster. For warming up a switch known to be hot, and for tests.
+  void promote() const {
+    std::lock_guard lock(d_builder_mutex);
+    d_promotion_started = true;
+    if (d_builder.joinable()) {
+      d_builder.join();
+    }
+    if (!is_promoted()) {
+      build(false);
+    }
+  }
+
+private:
+  using Compiled = CompiledSwitch<Switch>;
+
+  // Called from `evaluate`, which must not fail for want of a thread: if none
+  // can be started, the promotion is left to `promote`.
+  void start_promotion() const {
+    std::lock_guard lock(d_builder_mutex);
+    if (!d_promotion_started) {
+      try {
+        d_builder = std::thread([this] { build(true); });
+        d_promotion_started = true;
+      } catch (const std::system_error &) {
+      }
+    }
+  }
+
+  // Lookups timed per tier and round when deciding whether to promote.
+  static constexpr std::size_t k_SampleLabels = 256;
+  static constexpr std::size_t k_SampleLookups = 4096;
+  static constexpr int k_SampleRounds = 3;
+
+  // If compiling fails, or `if_faster` and the compiled switch is slower,
+  // the switch stays on its hash table.
+  void build(bool if_faster) const {
+    try {
+      auto compiled = std::make_unique<const Compiled>(d_switch, d_mode);
+      if (if_faster && !is_faster(*compiled)) {
+        return;
+      }
+      d_owned_compiled = std::move(compiled);
+    } catch (...) {
+      return;
+    }
+    d_compiled.store(d_owned_compiled.get(), std::memory_order_release);
+  }
+
+  // Whether `compiled` looks up a sample of the switch's labels at least as
+  // fast as the switch, taking the best of a few rounds of each.
+  bool is_faster(const Compiled &compiled) const {
+    std::vector<std::string_view> labels;
+    detail::SwitchAccess::for_each_case(
+        d_switch,
+        [&](std::string_view label, const auto &) { labels.push_back(label); });
+    if (labels.empty()) {
+      return true;
+    }
+    std::vector<std::string_view> sample;
+    const std::size_t stride =
+        std::max<std::size_t>(labels.size() / k_SampleLabels, 1);
+    for (std::size_t idx = 0; idx < labels.size(); idx += stride) {
+      sample.push_back(labels[idx]);
+    }
+
+    auto best_time = [&](const auto &tier) {
+      auto best = std::chrono::steady_clock::duration::max();
+      for (int round = 0; round != k_SampleRounds; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t idx = 0; idx != k_SampleLookups; ++idx) {
+          const auto result = tier.evaluate(sample[idx % sample.size()]);
+          // Keep the lookup from being optimized away.
+          asm volatile("" : : "g"(&result) : "memory");
+        }
+        best = std::min(best, std::chrono::steady_clock::now() - start);
+      }
+      return best;
+    };
+    return best_time(compiled) <= best_time(d_switch);
+  }
+
+  Switch d_switch;
+  std::size_t d_threshold;
+  JitMode d_mode;
+  mutable std::atomic<std::size_t> d_lookups{0};
+  // Null until published; owned by `d_owned_compiled`, which only the
+  // compiling thread writes.
+  mutable std::atomic<const Compiled *> d_compiled{nullptr};
+  mutable std::unique_ptr<const Compiled> d_owned_compiled;
+  // Guards starting and joining the compilation.
+  mutable std::mutex d_builder_mutex;
+  mutable bool d_promotion_started = false;
+  mutable std::thread d_builder;
+};
+
+} // namespace stringswitch
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_TIERED_H
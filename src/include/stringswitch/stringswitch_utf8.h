@@ -0,0 +1,123 @@
+#ifndef INCLUDED_STRINGSWITCH_STRINGSWITCH_UTF8_H
+#define INCLUDED_STRINGSWITCH_STRINGSWITCH_UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace stringswitch::detail {
+
+/// Returned by the decoders for a malformed code unit sequence.
+inline constexpr std::uint32_t k_InvalidCodePoint = UINT32_MAX;
+
+/// Write `code_point` to `out` as UTF-8, returning the number of bytes (at
+/// most 4) written.
+inline std::size_t encode_utf8(std::uint32_t code_point, char *out) {
+  if (code_point < 0x80) {
+    out[0] = static_cast<char>(code_point);
+    return 1;
+  }
+  if (code_point < 0x800) {
+    out[0] = static_cast<char>(0xC0 | code_point >> 6);
+    out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+    return 2;
+  }
+  if (code_point < 0x10000) {
+    out[0] = static_cast<char>(0xE0 | code_point >> 12);
+    out[1] = static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+    out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+    return 3;
+  }
+  out[0] = static_cast<char>(0xF0 | code_point >> 18);
+  out[1] = static_cast<char>(0x80 | (code_point >> 12 & 0x3F));
+  out[2] = static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+  out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+  return 4;
+}
+
+/// Decode the UTF-8 code point starting at `text[pos]` and advance `pos` past
+/// it. A malformed sequence (truncated, overlong, a surrogate or beyond
+/// U+10FFFF) decodes to `k_InvalidCodePoint` and advances `pos` by one byte.
+inline std::uint32_t decode_utf8(std::string_view text, std::size_t &pos) {
+  const auto lead = static_cast<unsigned char>(text[pos]);
+  if (lead < 0x80) {
+    ++pos;
+    return lead;
+  }
+  std::size_t size;
+  std::uint32_t code_point;
+  std::uint32_t min;
+  if (lead >= 0xC2 && lead < 0xE0) {
+    size = 2;
+    code_point = lead & 0x1F;
+    min = 0x80;
+  } else if (lead >= 0xE0 && lead < 0xF0) {
+    size = 3;
+    code_point = lead & 0x0F;
+    min = 0x800;
+  } else if (lead >= 0xF0 && lead < 0xF5) {
+    size = 4;
+    code_point = lead & 0x07;
+    min = 0x10000;
+  } else {
+    ++pos;
+    return k_InvalidCodePoint;
+  }
+  if (text.size() - pos < size) {
+    ++pos;
+    return k_InvalidCodePoint;
+  }
+  for (std::size_t idx = 1; idx != size; ++idx) {
+    const auto byte = static_cast<unsigned char>(text[pos + idx]);
+    if ((byte & 0xC0) != 0x80) {
+      ++pos;
+      return k_InvalidCodePoint;
+    }
+    code_point = code_point << 6 | (byte & 0x3F);
+  }
+  if (code_point < min || code_point > 0x10FFFF ||
+      (code_point >= 0xD800 && code_point < 0xE000)) {
+    ++pos;
+    return k_InvalidCodePoint;
+  }
+  pos += size;
+  return code_point;
+}
+
+/// Decode the code point starting at `units[pos]` and advance `pos` past it.
+///
+/// `CharT` code units are UTF-16 if they are 2 bytes wide, and UTF-32 if they
+/// are 4, so `wchar_t` follows the platform. A lone surrogate or a value
+/// beyond U+10FFFF decodes to `k_InvalidCodePoint`.
+template <class CharT>
+std::uint32_t decode_code_point(std::basic_string_view<CharT> units,
+                                std::size_t &pos) {
+  static_assert(sizeof(CharT) == 2 || sizeof(CharT) == 4,
+                "code units must be UTF-16 or UTF-32");
+  const auto unit = static_cast<std::uint32_t>(units[pos++]);
+  if (unit >= 0xDC00 && unit < 0xE000) {
+    return k_InvalidCodePoint;
+  }
+  if constexpr (sizeof(CharT) == 2) {
+    if (unit >= 0xD800 && unit < 0xDC00) {
+      if (pos == units.size()) {
+        return k_InvalidCodePoint;
+      }
+      const auto low = static_cast<std::uint32_t>(units[pos]);
+      if (low < 0xDC00 || low >= 0xE000) {
+        return k_InvalidCodePoint;
+      }
+      ++pos;
+      return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+    }
+  } else {
+    if ((unit >= 0xD800 && unit < 0xDC00) || unit > 0x10FFFF) {
+      return k_InvalidCodePoint;
+    }
+  }
+  return unit;
+}
+
+} // namespace stringswitch::detail
+
+#endif // INCLUDED_STRINGSWITCH_STRINGSWITCH_UTF8_H
@@ -0,0 +1,90 @@
+// The stringswitch library as a C++20 module, built when
+// STRINGSWITCH_BUILD_MODULE is on. `import stringswitch;` makes the public
+// API available without parsing the headers again.
+//
+// Macros cannot be exported: code using `STRINGSWITCH_INSTANTIATE` or
+// checking `STRINGSWITCH_JIT` still includes the headers.
+
+module;
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_batch.h"
+#include "stringswitch/stringswitch_complete.h"
+#include "stringswitch/stringswitch_cpu.h"
+#include "stringswitch/stringswitch_extras.h"
+#include "stringswitch/stringswitch_fields.h"
+#include "stringswitch/stringswitch_jit.h"
+#include "stringswitch/stringswitch_json.h"
+#include "stringswitch/stringswitch_lazy.h"
+#include "stringswitch/stringswitch_normalize.h"
+#include "stringswitch/stringswitch_registry.h"
+#include "stringswitch/stringswitch_routes.h"
+#include "stringswitch/stringswitch_suggest.h"
+#include "stringswitch/stringswitch_tiered.h"
+#include "stringswitch/stringswitch_unicode.h"
+
+export module stringswitch;
+
+export namespace stringswitch {
+// stringswitch.h
+using stringswitch::BasicStringKey;
+using stringswitch::BytesKey;
+using stringswitch::CompositeKey;
+using stringswitch::Completion;
+using stringswitch::FixedKey;
+using stringswitch::StringKey;
+using stringswitch::StringSwitch;
+using stringswitch::Suggestion;
+using stringswitch::TranscodingKey;
+
+// stringswitch_batch.h
+using stringswitch::BatchStrategy;
+using stringswitch::evaluate_batch;
+using stringswitch::histogram;
+using stringswitch::HistogramBin;
+using stringswitch::partition;
+using stringswitch::PartitionBucket;
+
+// stringswitch_cpu.h
+using stringswitch::active_isa;
+using stringswitch::detected_isa;
+using stringswitch::force_isa;
+using stringswitch::Isa;
+using stringswitch::reset_isa;
+
+// stringswitch_fields.h
+using stringswitch::BindStatus;
+using stringswitch::DefaultFieldParser;
+using stringswitch::FieldBinder;
+using stringswitch::FieldSet;
+using stringswitch::k_MaxBoundFields;
+
+// stringswitch_jit.h
+using stringswitch::CompiledSwitch;
+using stringswitch::JitMode;
+
+// stringswitch_lazy.h
+using stringswitch::Lazy;
+
+// stringswitch_normalize.h
+using stringswitch::FoldCase;
+using stringswitch::FoldSeparators;
+using stringswitch::NormalizedKey;
+using stringswitch::StripQuotes;
+using stringswitch::TrimWhitespace;
+
+// stringswitch_registry.h
+using stringswitch::PackedRegistry;
+using stringswitch::PackedSwitch;
+
+// stringswitch_routes.h
+using stringswitch::k_MaxRouteCaptures;
+using stringswitch::RouteMatch;
+using stringswitch::RouteSwitch;
+
+// stringswitch_tiered.h
+using stringswitch::TieredSwitch;
+
+// stringswitch_unicode.h
+using stringswitch::CanonicalKey;
+} // namespace stringswitch
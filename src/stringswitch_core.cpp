@@ -0,0 +1,11 @@
+// Explicit instantiations of the stringswitch engine for the result types in
+// `STRINGSWITCH_FOR_EACH_PRECOMPILED_RESULT`, shared by every translation unit
+// linking `stringswitch_core`.
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_complete.h"
+#include "stringswitch/stringswitch_extras.h"
+#include "stringswitch/stringswitch_json.h"
+#include "stringswitch/stringswitch_suggest.h"
+
+STRINGSWITCH_FOR_EACH_PRECOMPILED_RESULT(STRINGSWITCH_INSTANTIATE);
@@ -1,62 +1,38 @@
-#include <iostream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <optional>
-#include <ostream>
-#include <sstream>
+#include <span>
 #include <stdexcept>
-#include <array>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_complete.h"
+#include "stringswitch/stringswitch_extras.h"
+#include "stringswitch/stringswitch_json.h"
+#include "stringswitch/stringswitch_lazy.h"
+#include "stringswitch/stringswitch_normalize.h"
+#include "stringswitch/stringswitch_suggest.h"
+#include "stringswitch/stringswitch_unicode.h"
+#include "testing.h"
 
+using stringswitch::BasicStringKey;
+using stringswitch::BytesKey;
+using stringswitch::CanonicalKey;
+using stringswitch::CompositeKey;
+using stringswitch::FixedKey;
+using stringswitch::Lazy;
+using stringswitch::NormalizedKey;
 using stringswitch::StringSwitch;
-
-enum class Fruit { k_Apple = 0, k_Mango, k_Orange, k_Invalid = -1 };
-
-std::ostream &operator<<(std::ostream &os, const Fruit &fruit) {
-  switch (fruit) {
-  case Fruit::k_Apple:
-    os << "Fruit::k_Apple";
-    break;
-  case Fruit::k_Mango:
-    os << "Fruit::k_Mango";
-    break;
-  case Fruit::k_Orange:
-    os << "Fruit::k_Orange";
-    break;
-  case Fruit::k_Invalid:
-    os << "Fruit::k_Invalid";
-    break;
-  }
-  return os;
-}
-
-template <typename T>
-std::ostream &operator<<(std::ostream &os, const std::optional<T> &elem) {
-  if (elem.has_value()) {
-    os << "(" << elem.value() << ")";
-  } else {
-    os << "<nullopt>";
-  }
-  return os;
-}
-
-template <typename T>
-void assert_equal(const T &left, const T &right) {
-  if (left != right) {
-    std::stringstream message;
-    message << "The operands provided did not compare equal: \n\t" << left
-            << " != " << right;
-    throw std::runtime_error(message.str());
-  }
-}
-
-template <typename T>
-void assert_true(const T &value) {
-  if (!value) {
-    std::stringstream message;
-    message << "Expected argument to evaluate to true, but got false.";
-    throw std::runtime_error(message.str());
-  }
-}
+using stringswitch::TranscodingKey;
 
 void test_early_binding_with_default() {
   std::string param = "apple";
@@ -139,6 +115,759 @@ void test_late_binding_with_only_default() {
   }
 }
 
+void test_early_binding_default_before_case() {
+  auto result = StringSwitch<Fruit>::create("mango")
+                    .on_default(Fruit::k_Invalid)
+                    .when("mango", Fruit::k_Mango)
+                    .evaluate();
+
+  assert_equal(result, Fruit::k_Mango);
+}
+
+void test_ranges_with_exact_cases() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when_between("a", "m", Fruit::k_Apple)
+                      .when_between("m", "t", Fruit::k_Mango)
+                      .when_at_least("zz", Fruit::k_Orange)
+                      .when("kiwi", Fruit::k_Orange)
+                      .on_default(Fruit::k_Invalid);
+
+  assert_equal(switcher.evaluate("a"), Fruit::k_Apple);
+  assert_equal(switcher.evaluate("lychee"), Fruit::k_Apple);
+  assert_equal(switcher.evaluate("m"), Fruit::k_Mango);
+  assert_equal(switcher.evaluate("szzzzzzzzzzzzz"), Fruit::k_Mango);
+  assert_equal(switcher.evaluate("zz"), Fruit::k_Orange);
+  assert_equal(switcher.evaluate("zzz"), Fruit::k_Orange);
+  // Exact cases take precedence over ranges.
+  assert_equal(switcher.evaluate("kiwi"), Fruit::k_Orange);
+  // Gaps between ranges fall through to the default.
+  assert_equal(switcher.evaluate(""), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("A"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("t"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("z"), Fruit::k_Invalid);
+}
+
+void test_ranges_early_binding() {
+  auto result = StringSwitch<Fruit>::create("user:0042")
+                    .when_between("user:0000", "user:0100", Fruit::k_Apple)
+                    .evaluate();
+
+  assert_equal(result, std::optional<Fruit>(Fruit::k_Apple));
+}
+
+void test_ranges_agree_with_map() {
+  // Many shards sharing long prefixes, so that lookups have to compare full
+  // strings past the 8-byte prefixes.
+  std::map<std::string, int> starts;
+  std::vector<std::string> bounds;
+  for (int idx = 0; idx != 200; ++idx) {
+    bounds.push_back("shard/" + std::to_string(1000 + idx * 37));
+  }
+  auto ranged = StringSwitch<int>::create().on_default(-2);
+  for (std::size_t idx = 0; idx + 1 < bounds.size(); idx += 2) {
+    ranged.when_between(bounds[idx], bounds[idx + 1], static_cast<int>(idx));
+    starts[bounds[idx]] = static_cast<int>(idx);
+    starts[bounds[idx + 1]] = -2;
+  }
+
+  for (int probe = 900; probe < 9000; probe += 7) {
+    const std::string shard = "shard/" + std::to_string(probe);
+    for (const std::string &key : {shard, shard + "/suffix"}) {
+      auto it = starts.upper_bound(key);
+      const int expected = it == starts.begin() ? -2 : std::prev(it)->second;
+      assert_equal(ranged.evaluate(key), expected);
+    }
+  }
+  for (const std::string &bound : bounds) {
+    assert_equal(ranged.evaluate(bound), starts[bound]);
+  }
+}
+
+void test_ranges_added_after_lookups() {
+  auto switcher = StringSwitch<int>::create().on_default(-1);
+  switcher.when_between("b", "d", 1);
+  assert_equal(switcher.evaluate("c"), 1);
+  const auto copy = switcher;
+
+  // Ranges are compiled again on the first lookup after a change, and
+  // inserted in order however they were added.
+  switcher.when_at_least("x", 2).when_between("a", "b", 3);
+  assert_equal(switcher.evaluate("a"), 3);
+  assert_equal(switcher.evaluate("c"), 1);
+  assert_equal(switcher.evaluate("y"), 2);
+  assert_equal(switcher.evaluate("e"), -1);
+  assert_equal(copy.evaluate("y"), -1);
+  assert_equal(copy.evaluate("c"), 1);
+}
+
+void test_invalid_ranges_throw() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when_between("b", "d", Fruit::k_Apple)
+                      .when_at_least("x", Fruit::k_Mango);
+
+  auto throws = [&](std::string_view lower,
+                    std::optional<std::string_view> upper) {
+    try {
+      if (upper) {
+        switcher.when_between(lower, *upper, Fruit::k_Orange);
+      } else {
+        switcher.when_at_least(lower, Fruit::k_Orange);
+      }
+    } catch (const std::invalid_argument &) {
+      return true;
+    }
+    return false;
+  };
+  assert_true(throws("a", "c"));
+  assert_true(throws("c", "e"));
+  assert_true(throws("b", "d"));
+  assert_true(throws("y", std::nullopt));
+  assert_true(throws("q", "z"));
+  assert_true(throws("a", std::nullopt));
+  // Empty ranges are rejected too.
+  assert_true(throws("f", "f"));
+
+  // Adjacent ranges don't overlap.
+  switcher.when_between("a", "b", Fruit::k_Orange)
+      .when_between("d", "x", Fruit::k_Orange);
+  assert_equal(switcher.evaluate("a"), std::optional<Fruit>(Fruit::k_Orange));
+  assert_equal(switcher.evaluate("c"), std::optional<Fruit>(Fruit::k_Apple));
+  assert_equal(switcher.evaluate("w"), std::optional<Fruit>(Fruit::k_Orange));
+}
+
+void test_composite_keys() {
+  auto switcher = StringSwitch<Fruit, CompositeKey<2>>::create()
+                      .when({"GET", "json"}, Fruit::k_Apple)
+                      .when({"GET", "xml"}, Fruit::k_Mango)
+                      .when({"POST", "json"}, Fruit::k_Orange)
+                      .on_default(Fruit::k_Invalid);
+
+  assert_equal(switcher.evaluate({"GET", "json"}), Fruit::k_Apple);
+  assert_equal(switcher.evaluate({"GET", "xml"}), Fruit::k_Mango);
+  assert_equal(switcher.evaluate({"POST", "json"}), Fruit::k_Orange);
+  assert_equal(switcher.evaluate({"POST", "xml"}), Fruit::k_Invalid);
+
+  // Components are compared separately, not concatenated.
+  assert_equal(switcher.evaluate({"GETj", "son"}), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate({"", "GETjson"}), Fruit::k_Invalid);
+
+  // Parameters can be borrowed from any string.
+  const std::string method = "GET";
+  const std::string type = "xml";
+  assert_equal(switcher.evaluate({method, type}), Fruit::k_Mango);
+}
+
+void test_composite_keys_early_binding() {
+  std::string method = "POST";
+  auto result = StringSwitch<Fruit, CompositeKey<3>>::create(
+                    {method, "json", "v2"})
+                    .when({"POST", "json", "v1"}, Fruit::k_Apple)
+                    .when({"POST", "json", "v2"}, Fruit::k_Mango)
+                    .evaluate();
+  assert_equal(result, std::optional<Fruit>(Fruit::k_Mango));
+
+  auto only_default =
+      StringSwitch<Fruit, CompositeKey<2>>::create({"a", "b"})
+          .on_default(Fruit::k_Orange)
+          .evaluate();
+  assert_equal(only_default, Fruit::k_Orange);
+}
+
+void test_normalized_keys() {
+  using stringswitch::FoldCase;
+  using stringswitch::FoldSeparators;
+  using stringswitch::StripQuotes;
+  using stringswitch::TrimWhitespace;
+  using Lenient =
+      NormalizedKey<TrimWhitespace, StripQuotes, FoldCase, FoldSeparators>;
+
+  // Labels are normalized too.
+  auto switcher = StringSwitch<Fruit, Lenient>::create()
+                      .when("Green-Apple", Fruit::k_Apple)
+                      .when(" 'mango' ", Fruit::k_Mango)
+                      .when("blood.orange.from.the.south", Fruit::k_Orange)
+                      .on_default(Fruit::k_Invalid);
+
+  assert_equal(switcher.evaluate("green-apple"), Fruit::k_Apple);
+  assert_equal(switcher.evaluate("  \"GREEN_APPLE\"\t"), Fruit::k_Apple);
+  assert_equal(switcher.evaluate("green.apple"), Fruit::k_Apple);
+  assert_equal(switcher.evaluate("MANGO"), Fruit::k_Mango);
+  assert_equal(switcher.evaluate("Blood_Orange-From.The_South"),
+               Fruit::k_Orange);
+
+  // Trims run in order, before the maps, and strip a single matching pair.
+  assert_equal(switcher.evaluate("\" mango\""), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("\"mango'"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("\"\"mango\"\""), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("green apple"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("green-apples"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate(""), Fruit::k_Invalid);
+
+  // Steps only apply when asked for.
+  auto folded = StringSwitch<Fruit, NormalizedKey<FoldCase>>::create(" Mango")
+                    .when("mango", Fruit::k_Mango)
+                    .when(" mango", Fruit::k_Orange)
+                    .evaluate();
+  assert_equal(folded, std::optional<Fruit>(Fruit::k_Orange));
+}
+
+template <class Key>
+void check_bindings_agree(std::string_view param, std::string_view label) {
+  auto late = StringSwitch<int, Key>::create().when(label, 1).on_default(0);
+  auto early =
+      StringSwitch<int, Key>::create(param).when(label, 1).on_default(0);
+  assert_equal(early.evaluate(), late.evaluate(param));
+}
+
+void test_normalized_keys_bind_alike() {
+  using stringswitch::StripQuotes;
+  using stringswitch::TrimWhitespace;
+
+  // Trims that are not idempotent: the early-bound parameter is normalized
+  // once, like a late-bound one, and not again on `evaluate`.
+  check_bindings_agree<NormalizedKey<TrimWhitespace, StripQuotes>>("\" a \"",
+                                                                   "a");
+  check_bindings_agree<NormalizedKey<TrimWhitespace, StripQuotes>>("\" a \"",
+                                                                   " a ");
+  check_bindings_agree<NormalizedKey<StripQuotes>>("\"'x'\"", "x");
+  check_bindings_agree<NormalizedKey<StripQuotes>>("\"'x'\"", "'x'");
+  check_bindings_agree<NormalizedKey<StripQuotes>>("\"'x'\"", "\"'x'\"");
+}
+
+void test_wide_keys() {
+  auto utf16 = StringSwitch<Fruit, BasicStringKey<char16_t>>::create()
+                   .when(u"apple", Fruit::k_Apple)
+                   .when(u"\u00e4pfel", Fruit::k_Mango)
+                   .on_default(Fruit::k_Invalid);
+  assert_equal(utf16.evaluate(u"apple"), Fruit::k_Apple);
+  assert_equal(utf16.evaluate(std::u16string(u"\u00e4pfel")), Fruit::k_Mango);
+  assert_equal(utf16.evaluate(u"apfel"), Fruit::k_Invalid);
+
+  auto utf32 = StringSwitch<Fruit, BasicStringKey<char32_t>>::create(U"mango")
+                   .when(U"mango", Fruit::k_Mango)
+                   .evaluate();
+  assert_equal(utf32, std::optional<Fruit>(Fruit::k_Mango));
+
+  auto wide = StringSwitch<Fruit, BasicStringKey<wchar_t>>::create()
+                  .when(L"orange", Fruit::k_Orange);
+  assert_equal(wide.evaluate(L"orange"), std::optional<Fruit>(Fruit::k_Orange));
+
+  auto utf8 = StringSwitch<Fruit, BasicStringKey<char8_t>>::create()
+                  .when(u8"gr\u00fcn", Fruit::k_Apple);
+  assert_equal(utf8.evaluate(u8"gr\u00fcn"), std::optional(Fruit::k_Apple));
+}
+
+void test_transcoding_keys() {
+  // One label per UTF-8 sequence length, including a surrogate pair in UTF-16.
+  auto utf16 = StringSwitch<Fruit, TranscodingKey<char16_t>>::create()
+                   .when("apple", Fruit::k_Apple)
+                   .when("gr\u00fc\u00dfe", Fruit::k_Mango)
+                   .when("\u20ac \U0001F34A", Fruit::k_Orange)
+                   .on_default(Fruit::k_Invalid);
+
+  assert_equal(utf16.evaluate(u"apple"), Fruit::k_Apple);
+  assert_equal(utf16.evaluate(u"gr\u00fc\u00dfe"), Fruit::k_Mango);
+  assert_equal(utf16.evaluate(u"\u20ac \U0001F34A"), Fruit::k_Orange);
+  // UTF-8 parameters work too.
+  assert_equal(utf16.evaluate("apple"), Fruit::k_Apple);
+  assert_equal(utf16.evaluate(std::string("gr\u00fc\u00dfe")),
+               Fruit::k_Mango);
+
+  assert_equal(utf16.evaluate(u"appl"), Fruit::k_Invalid);
+  assert_equal(utf16.evaluate(u"gr\u00fc\u00df"), Fruit::k_Invalid);
+  assert_equal(utf16.evaluate(u"gr\u00fc\u00dfee"), Fruit::k_Invalid);
+  assert_equal(utf16.evaluate(u""), Fruit::k_Invalid);
+  // A lone surrogate matches nothing, even where the label would go on.
+  const char16_t lone[] = {0x20AC, u' ', 0xD83C, 0};
+  assert_equal(utf16.evaluate(lone), Fruit::k_Invalid);
+
+  auto utf32 = StringSwitch<Fruit, TranscodingKey<char32_t>>::create(
+                   std::u32string(U"\u20ac \U0001F34A"))
+                   .when(U"\u20ac \U0001F34A", Fruit::k_Orange)
+                   .evaluate();
+  assert_equal(utf32, std::optional(Fruit::k_Orange));
+
+  auto wide = StringSwitch<Fruit, TranscodingKey<wchar_t>>::create()
+                  .when("gr\u00fc\u00dfe", Fruit::k_Mango);
+  assert_equal(wide.evaluate(L"gr\u00fc\u00dfe"),
+               std::optional(Fruit::k_Mango));
+
+  // Bound early, the same parameter misses too rather than throwing, even
+  // with a label matching the part before the surrogate.
+  auto prefix = StringSwitch<Fruit, TranscodingKey<char16_t>>::create()
+                    .when("\u20ac ", Fruit::k_Orange)
+                    .on_default(Fruit::k_Invalid);
+  assert_equal(prefix.evaluate(lone), Fruit::k_Invalid);
+  auto early = StringSwitch<Fruit, TranscodingKey<char16_t>>::create(lone)
+                   .when("\u20ac ", Fruit::k_Orange)
+                   .when("", Fruit::k_Apple)
+                   .on_default(Fruit::k_Invalid);
+  assert_equal(early.evaluate(), Fruit::k_Invalid);
+  assert_true(!StringSwitch<Fruit, TranscodingKey<char16_t>>::create(lone)
+                   .when("", Fruit::k_Apple)
+                   .evaluate());
+
+  bool threw = false;
+  try {
+    utf16.when(lone, Fruit::k_Apple);
+  } catch (const std::invalid_argument &) {
+    threw = true;
+  }
+  assert_true(threw);
+}
+
+void test_canonical_keys() {
+  // Labels in NFC, NFD or a mix of both.
+  auto switcher = StringSwitch<Fruit, CanonicalKey>::create()
+                      .when("Z\u00fcrich", Fruit::k_Apple)
+                      .when("Mala\u0301ga", Fruit::k_Mango)
+                      .when("H\u1ed9i An", Fruit::k_Orange)
+                      .on_default(Fruit::k_Invalid);
+
+  assert_equal(switcher.evaluate("Z\u00fcrich"), Fruit::k_Apple);
+  assert_equal(switcher.evaluate("Zu\u0308rich"), Fruit::k_Apple);
+  assert_equal(switcher.evaluate("M\u00e1laga"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("Mal\u00e1ga"), Fruit::k_Mango);
+  assert_equal(switcher.evaluate("Mala\u0301ga"), Fruit::k_Mango);
+
+  // U+1ED9 is o with a dot below (class 220) and a circumflex (class 230):
+  // either order of the marks, and any mix of composition, is equivalent.
+  assert_equal(switcher.evaluate("H\u1ed9i An"), Fruit::k_Orange);
+  assert_equal(switcher.evaluate("Ho\u0323\u0302i An"), Fruit::k_Orange);
+  assert_equal(switcher.evaluate("Ho\u0302\u0323i An"), Fruit::k_Orange);
+  assert_equal(switcher.evaluate("H\u00f4\u0323i An"), Fruit::k_Orange);
+  assert_equal(switcher.evaluate("H\u1ecd\u0302i An"), Fruit::k_Orange);
+  // Marks of the same class keep their order.
+  assert_equal(switcher.evaluate("Ho\u0302\u0301i An"), Fruit::k_Invalid);
+
+  assert_equal(switcher.evaluate("Zurich"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("Z\u00fcric"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate("Z\u00fcrich\u0301"), Fruit::k_Invalid);
+  assert_equal(switcher.evaluate(""), Fruit::k_Invalid);
+  // Invalid UTF-8 only matches itself.
+  assert_equal(switcher.evaluate("Z\xc3rich"), Fruit::k_Invalid);
+  switcher.when("Z\xc3rich", Fruit::k_Mango);
+  assert_equal(switcher.evaluate("Z\xc3rich"), Fruit::k_Mango);
+
+  // ASCII parameters take the fast path.
+  auto ascii = StringSwitch<Fruit, CanonicalKey>::create("apple")
+                   .when("apple", Fruit::k_Apple)
+                   .evaluate();
+  assert_equal(ascii, std::optional(Fruit::k_Apple));
+}
+
+std::size_t reference_distance(std::string_view lhs, std::string_view rhs) {
+  std::vector<std::vector<std::size_t>> dist(
+      lhs.size() + 1, std::vector<std::size_t>(rhs.size() + 1));
+  for (std::size_t row = 0; row <= lhs.size(); ++row) {
+    for (std::size_t col = 0; col <= rhs.size(); ++col) {
+      if (row == 0 || col == 0) {
+        dist[row][col] = row + col;
+      } else {
+        dist[row][col] = std::min(
+            {dist[row - 1][col] + 1,
+             dist[row][col - 1] + 1,
+             dist[row - 1][col - 1] + (lhs[row - 1] != rhs[col - 1])});
+      }
+    }
+  }
+  return dist[lhs.size()][rhs.size()];
+}
+
+// The bytes of `text`, without its terminator.
+template <std::size_t N>
+std::array<std::byte, N - 1> bytes_of(const char (&text)[N]) {
+  std::array<std::byte, N - 1> bytes;
+  for (std::size_t idx = 0; idx != N - 1; ++idx) {
+    bytes[idx] = static_cast<std::byte>(text[idx]);
+  }
+  return bytes;
+}
+
+void test_byte_keys() {
+  const auto ping = bytes_of("\x01\x00ping");
+  const auto pong = bytes_of("\x01\x00pong");
+  auto switcher = StringSwitch<Fruit, BytesKey>::create()
+                      .when(ping, Fruit::k_Apple)
+                      .when(pong, Fruit::k_Mango)
+                      .when({}, Fruit::k_Orange)
+                      .on_default(Fruit::k_Invalid);
+
+  assert_equal(switcher.evaluate(ping), Fruit::k_Apple);
+  assert_equal(switcher.evaluate(pong), Fruit::k_Mango);
+  assert_equal(switcher.evaluate({}), Fruit::k_Orange);
+  // Embedded zero bytes are part of the key.
+  assert_equal(switcher.evaluate(std::span(ping).subspan(1)),
+               Fruit::k_Invalid);
+
+  // Keys can be sliced out of a larger message.
+  const auto message = bytes_of("header\x01\x00pongtrailer");
+  assert_equal(switcher.evaluate(std::span(message).subspan(6, pong.size())),
+               Fruit::k_Mango);
+}
+
+void test_fixed_keys() {
+  const auto elf = bytes_of("\x7f" "ELF");
+  const auto pdf = bytes_of("%PDF");
+  auto magic = StringSwitch<Fruit, FixedKey<4>>::create()
+                   .when(elf, Fruit::k_Apple)
+                   .when(pdf, Fruit::k_Mango)
+                   .on_default(Fruit::k_Invalid);
+  assert_equal(magic.evaluate(elf), Fruit::k_Apple);
+  assert_equal(magic.evaluate(pdf), Fruit::k_Mango);
+  assert_equal(magic.evaluate(bytes_of("%PDE")), Fruit::k_Invalid);
+
+  const auto file = bytes_of("%PDF-1.7");
+  assert_equal(magic.evaluate(std::span(file).first<4>()), Fruit::k_Mango);
+
+  auto early = StringSwitch<Fruit, FixedKey<4>>::create(elf)
+                   .when(pdf, Fruit::k_Mango)
+                   .when(elf, Fruit::k_Apple)
+                   .evaluate();
+  assert_equal(early, std::optional(Fruit::k_Apple));
+
+  // Every size up to 33 bytes, with keys differing in a single byte.
+  auto check_size = [](auto size) {
+    constexpr std::size_t k_Size = decltype(size)::value;
+    std::array<std::byte, k_Size> label{};
+    auto sw = StringSwitch<std::size_t, FixedKey<k_Size>>::create()
+                  .on_default(std::size_t{k_Size});
+    for (std::size_t idx = 0; idx != k_Size; ++idx) {
+      label[idx] = std::byte{1};
+      sw.when(label, idx);
+      label[idx] = std::byte{0};
+    }
+    assert_equal(sw.evaluate(label), k_Size);
+    for (std::size_t idx = 0; idx != k_Size; ++idx) {
+      label[idx] = std::byte{1};
+      assert_equal(sw.evaluate(label), idx);
+      label[idx] = std::byte{0};
+    }
+  };
+  [&]<std::size_t... Sizes>(std::index_sequence<Sizes...>) {
+    (check_size(std::integral_constant<std::size_t, Sizes + 1>{}), ...);
+  }(std::make_index_sequence<33>{});
+}
+
+void test_lazy_results() {
+  int built = 0;
+  auto factory = [&built](std::string name) {
+    return [&built, name] {
+      ++built;
+      return name;
+    };
+  };
+  auto switcher = StringSwitch<Lazy<std::string>>::create()
+                      .when_lazy("apple", factory("Apple"))
+                      .when_lazy("mango", factory("Mango"))
+                      .on_default(std::string("none"));
+  assert_equal(built, 0);
+
+  const Lazy<std::string> apple = switcher.evaluate("apple");
+  assert_true(!apple.is_built());
+  assert_equal(apple.get(), std::string("Apple"));
+  assert_equal(built, 1);
+  // Later lookups, and copies of the switch, share the built value.
+  const auto copy = switcher;
+  assert_equal(*copy.evaluate("apple"), std::string("Apple"));
+  assert_equal(switcher.evaluate("apple")->size(), std::size_t{5});
+  assert_equal(built, 1);
+  assert_true(!switcher.evaluate("mango").is_built());
+  assert_equal(*switcher.evaluate("kiwi"), std::string("none"));
+
+  // A factory that throws is retried by the next `get`.
+  bool fail = true;
+  auto flaky = StringSwitch<Lazy<int>>::create().when_lazy("flaky", [&] {
+    if (std::exchange(fail, false)) {
+      throw std::runtime_error("not yet");
+    }
+    return 42;
+  });
+  bool threw = false;
+  try {
+    flaky.evaluate("flaky")->get();
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  assert_true(threw);
+  assert_equal(flaky.evaluate("flaky")->get(), 42);
+}
+
+void test_lazy_results_outlive_lookups() {
+  // Factories may be move-only.
+  auto answer = std::make_unique<int>(42);
+  auto switcher = StringSwitch<Lazy<int>>::create()
+                      .when_lazy("answer",
+                                 [answer = std::move(answer)] {
+                                   return *answer;
+                                 })
+                      .on_default(0);
+  const Lazy<int> first = switcher.evaluate("answer");
+  const Lazy<int> second = switcher.evaluate("answer");
+  assert_equal(first.get(), 42);
+  assert_true(second.is_built());
+  assert_equal(*switcher.evaluate("kiwi"), 0);
+
+  // An early-bound switch is a temporary, so its result must own its value.
+  const Lazy<int> early = StringSwitch<Lazy<int>>::create("answer")
+                              .when_lazy("answer", [] { return 7; })
+                              .on_default(0)
+                              .evaluate();
+  assert_equal(early.get(), 7);
+  const Lazy<int> fallback = StringSwitch<Lazy<int>>::create("kiwi")
+                                 .when_lazy("answer", [] { return 7; })
+                                 .on_default(3)
+                                 .evaluate();
+  assert_equal(fallback.get(), 3);
+}
+
+void test_lazy_results_build_once_across_threads() {
+  std::atomic<int> built = 0;
+  // Slow enough for every thread to find the table unbuilt.
+  auto build_table = [&built] {
+    ++built;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return std::vector<int>(1000, 7);
+  };
+  auto switcher = StringSwitch<Lazy<std::vector<int>>>::create()
+                      .when_lazy("table", build_table)
+                      .on_default(std::vector<int>());
+
+  std::vector<std::thread> threads;
+  std::atomic<int> sum = 0;
+  for (int idx = 0; idx != 8; ++idx) {
+    threads.emplace_back([&] { sum += switcher.evaluate("table")->at(999); });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  assert_equal(built.load(), 1);
+  assert_equal(sum.load(), 8 * 7);
+}
+
+void test_nearest() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .when("orange", Fruit::k_Orange)
+                      .on_default(Fruit::k_Invalid);
+
+  auto suggestion = switcher.nearest("aple", 2);
+  assert_true(suggestion.has_value());
+  assert_equal(suggestion->label, std::string_view("apple"));
+  assert_equal(suggestion->distance, std::size_t{1});
+  assert_equal(switcher.nearest("orange", 0)->distance, std::size_t{0});
+  assert_true(!switcher.nearest("banana", 2));
+
+  // Ties go to the smallest label.
+  auto ties = StringSwitch<Fruit>::create()
+                  .when("bat", Fruit::k_Mango)
+                  .when("cat", Fruit::k_Orange)
+                  .when("art", Fruit::k_Apple);
+  assert_equal(ties.nearest("at", 1)->label, std::string_view("art"));
+
+  // New cases are picked up.
+  switcher.when("banana", Fruit::k_Apple);
+  assert_equal(switcher.nearest("banan", 2)->label, std::string_view("banana"));
+
+  auto empty = StringSwitch<Fruit>::create().on_default(Fruit::k_Invalid);
+  assert_true(!empty.nearest("apple", 10));
+}
+
+void test_nearest_at_any_distance() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("a much longer label", Fruit::k_Mango);
+
+  // Limits past the longest possible distance don't overflow the search.
+  const std::size_t k_Any = SIZE_MAX;
+  assert_equal(switcher.nearest("zzzzzzzzzz", k_Any)->label,
+               std::string_view("apple"));
+  assert_equal(switcher.nearest("zzzzzzzzzz", k_Any)->distance,
+               std::size_t{10});
+  assert_equal(switcher.nearest("", k_Any)->distance, std::size_t{5});
+  assert_equal(switcher.nearest("a much longer label!", k_Any - 1)->distance,
+               std::size_t{1});
+  assert_true(
+      !StringSwitch<Fruit>::create().on_default(Fruit::k_Apple).nearest(
+          "apple", k_Any));
+}
+
+void test_nearest_agrees_with_brute_force() {
+  std::vector<std::string> labels;
+  std::uint32_t state = 7;
+  auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return state >> 16;
+  };
+  auto random_word = [&](std::size_t max_size) {
+    std::string word(next() % (max_size + 1), '\0');
+    for (char &c : word) {
+      c = static_cast<char>('a' + next() % 4);
+    }
+    return word;
+  };
+
+  auto switcher = StringSwitch<int>::create().on_default(-1);
+  for (int idx = 0; idx != 300; ++idx) {
+    // Some labels are longer than a machine word.
+    labels.push_back(random_word(idx % 10 == 0 ? 80 : 10));
+    switcher.when(labels.back(), idx);
+  }
+  for (int query = 0; query != 200; ++query) {
+    const std::string param = random_word(query % 10 == 0 ? 90 : 12);
+    const std::size_t max_distance = query % 4;
+    std::optional<std::size_t> best;
+    for (const std::string &label : labels) {
+      const std::size_t distance = reference_distance(param, label);
+      if (distance <= max_distance && (!best || distance < *best)) {
+        best = distance;
+      }
+    }
+    auto suggestion = switcher.nearest(param, max_distance);
+    assert_equal(suggestion.has_value(), best.has_value());
+    if (suggestion) {
+      assert_equal(suggestion->distance, *best);
+      assert_equal(reference_distance(param, suggestion->label), *best);
+    }
+  }
+}
+
+// The labels of `completions`, joined by commas.
+template <typename Completions>
+std::string labels_of(const Completions &completions) {
+  std::string labels;
+  for (const auto &completion : completions) {
+    labels += (labels.empty() ? "" : ",") + std::string(completion.label);
+  }
+  return labels;
+}
+
+void test_complete() {
+  auto switcher = StringSwitch<int>::create()
+                      .when("select", 1, 50)
+                      .when("set", 2, 90)
+                      .when("show", 3, 70)
+                      .when("sequence", 4)
+                      .when("session", 5, 50)
+                      .when("update", 6, 100)
+                      .on_default(0);
+
+  auto completions = switcher.complete("se", 3);
+  assert_equal(labels_of(completions),
+               std::string("set,select,session"));
+  assert_equal(completions[0].result, 2);
+  assert_equal(completions[0].weight, std::uint64_t{90});
+
+  // Fewer matches than requested.
+  assert_equal(labels_of(switcher.complete("sh", 5)),
+               std::string("show"));
+  assert_equal(switcher.complete("sel", 0).size(), std::size_t{0});
+  assert_equal(switcher.complete("x", 3).size(), std::size_t{0});
+  assert_equal(switcher.complete("", 7).size(), std::size_t{6});
+  assert_equal(switcher.complete("", 1)[0].result, 6);
+
+  // Weights can be updated, e.g. from hit counts.
+  switcher.set_weight("sequence", 95);
+  assert_equal(labels_of(switcher.complete("se", 2)),
+               std::string("sequence,set"));
+
+  // Copies share weights and indexes only until either changes them.
+  auto copy = switcher;
+  copy.set_weight("session", 99).when("seal", 7, 98);
+  assert_equal(labels_of(copy.complete("se", 3)),
+               std::string("session,seal,sequence"));
+  assert_equal(labels_of(switcher.complete("se", 2)),
+               std::string("sequence,set"));
+  assert_equal(switcher.evaluate("seal"), 0);
+
+  bool threw = false;
+  try {
+    switcher.set_weight("missing", 1);
+  } catch (const std::invalid_argument &) {
+    threw = true;
+  }
+  assert_true(threw);
+}
+
+void test_complete_agrees_with_sorting() {
+  std::map<std::string, std::uint64_t> weights;
+  std::uint32_t state = 99;
+  auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return state >> 16;
+  };
+  auto switcher = StringSwitch<int>::create().on_default(-1);
+  for (int idx = 0; idx != 500; ++idx) {
+    std::string label(1 + next() % 6, 'a');
+    for (char &c : label) {
+      c = static_cast<char>('a' + next() % 3);
+    }
+    const std::uint64_t weight = next() % 20;
+    if (weights.emplace(label, weight).second) {
+      switcher.when(label, idx, weight);
+    }
+  }
+  for (const std::string prefix : {"", "a", "ab", "cab", "bbb", "abcabc"}) {
+    for (std::size_t k : {1, 3, 10, 1000}) {
+      std::vector<std::pair<std::string, std::uint64_t>> expected;
+      for (const auto &[label, weight] : weights) {
+        if (label.starts_with(prefix)) {
+          expected.emplace_back(label, weight);
+        }
+      }
+      std::stable_sort(expected.begin(), expected.end(), [](auto &l, auto &r) {
+        return l.second > r.second;
+      });
+      expected.resize(std::min(expected.size(), k));
+
+      auto actual = switcher.complete(prefix, k);
+      assert_equal(actual.size(), expected.size());
+      for (std::size_t idx = 0; idx != actual.size(); ++idx) {
+        assert_equal(std::string(actual[idx].label), expected[idx].first);
+        assert_equal(actual[idx].weight, expected[idx].second);
+      }
+    }
+  }
+}
+
+void test_evaluate_json_escaped() {
+  auto switcher = StringSwitch<int>::create()
+                      .when("name", 1)
+                      .when("say \"hi\"", 2)
+                      .when("back\\slash/", 3)
+                      .when("caf\xC3\xA9", 4)
+                      .when("\xF0\x9F\x98\x80", 5)
+                      .when("tab\tnewline\n", 6)
+                      .when(std::string(300, 'k') + "\"", 7)
+                      .on_default(0);
+
+  assert_equal(switcher.evaluate_json_escaped("name"), 1);
+  assert_equal(switcher.evaluate_json_escaped("\\u006eame"), 1);
+  assert_equal(switcher.evaluate_json_escaped("say \\\"hi\\\""), 2);
+  assert_equal(switcher.evaluate_json_escaped("back\\\\slash\\/"), 3);
+  assert_equal(switcher.evaluate_json_escaped("back\\\\slash/"), 3);
+  assert_equal(switcher.evaluate_json_escaped("caf\\u00e9"), 4);
+  assert_equal(switcher.evaluate_json_escaped("caf\\u00E9"), 4);
+  assert_equal(switcher.evaluate_json_escaped("\\ud83d\\ude00"), 5);
+  assert_equal(switcher.evaluate_json_escaped("tab\\tnewline\\n"), 6);
+  // Longer than the stack buffer.
+  assert_equal(
+      switcher.evaluate_json_escaped(std::string(300, 'k') + "\\\""), 7);
+  assert_equal(switcher.evaluate_json_escaped("nam"), 0);
+
+  // Malformed escapes never match.
+  for (std::string_view raw : {"name\\", "\\x6eame", "\\u006", "\\u00zz",
+                               "\\ud83d", "\\ude00", "\\ud83d\\u0041"}) {
+    assert_equal(switcher.evaluate_json_escaped(raw), 0);
+  }
+
+  // Without a default, a miss is empty.
+  auto partial = StringSwitch<int>::create().when("a", 1);
+  assert_equal(partial.evaluate_json_escaped("\\u0061"), std::optional(1));
+  assert_equal(partial.evaluate_json_escaped("\\q"), std::optional<int>());
+}
+
 int main() {
   test_early_binding_with_default();
   test_early_binding_without_default();
@@ -147,4 +876,35 @@ int main() {
   test_late_binding_with_default();
   test_late_binding_without_default();
   test_late_binding_with_only_default();
+
+  test_early_binding_default_before_case();
+
+  test_ranges_with_exact_cases();
+  test_ranges_early_binding();
+  test_ranges_agree_with_map();
+  test_ranges_added_after_lookups();
+  test_invalid_ranges_throw();
+
+  test_composite_keys();
+  test_composite_keys_early_binding();
+  test_normalized_keys();
+  test_normalized_keys_bind_alike();
+  test_wide_keys();
+  test_transcoding_keys();
+  test_canonical_keys();
+  test_byte_keys();
+  test_fixed_keys();
+
+  test_lazy_results();
+  test_lazy_results_outlive_lookups();
+  test_lazy_results_build_once_across_threads();
+
+  test_nearest();
+  test_nearest_at_any_distance();
+  test_nearest_agrees_with_brute_force();
+
+  test_complete();
+  test_complete_agrees_with_sorting();
+
+  test_evaluate_json_escaped();
 }
@@ -0,0 +1,291 @@
+// Counts the allocations made by each way of building and evaluating a
+// stringswitch, by replacing the global `operator new`. Lookup paths that are
+// meant to be allocation-free fail the test if they allocate; build paths
+// are only reported, per call, so changes in their cost show up in the log.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_batch.h"
+#include "stringswitch/stringswitch_extras.h"
+#include "stringswitch/stringswitch_jit.h"
+#include "stringswitch/stringswitch_json.h"
+#include "stringswitch/stringswitch_normalize.h"
+#include "stringswitch/stringswitch_routes.h"
+#include "stringswitch/stringswitch_tiered.h"
+#include "stringswitch/stringswitch_unicode.h"
+#include "testing.h"
+
+namespace {
+
+std::atomic<std::size_t> g_allocations{0};
+std::atomic<std::size_t> g_bytes{0};
+
+void *counted_allocate(std::size_t size, std::size_t alignment) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(size, std::memory_order_relaxed);
+  // `aligned_alloc` wants a multiple of the alignment.
+  const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+  void *ptr = alignment <= alignof(std::max_align_t)
+                  ? std::malloc(size == 0 ? 1 : size)
+                  : std::aligned_alloc(alignment, rounded);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+// Out of line, so the compiler doesn't pair the `free` with the `new` it was
+// inlined into and warn about the mismatch.
+[[gnu::noinline]] void deallocate(void *ptr) { std::free(ptr); }
+
+} // namespace
+
+// The array and nothrow forms forward to these by default.
+void *operator new(std::size_t size) {
+  return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { deallocate(ptr); }
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+
+using stringswitch::CanonicalKey;
+using stringswitch::CompiledSwitch;
+using stringswitch::FixedKey;
+using stringswitch::FoldCase;
+using stringswitch::NormalizedKey;
+using stringswitch::RouteSwitch;
+using stringswitch::StringSwitch;
+using stringswitch::TieredSwitch;
+using stringswitch::TrimWhitespace;
+using stringswitch::TranscodingKey;
+
+namespace {
+
+constexpr int k_Repetitions = 100;
+
+// Longer than any small-string buffer, so a temporary `std::string` of a
+// parameter would allocate.
+constexpr std::string_view k_LongLabel =
+    "a label that is much too long to fit in a small string buffer";
+
+struct Allocations {
+  double count;
+  double bytes;
+};
+
+// The allocations made by one call of `run`, averaged over repetitions.
+template <class Run>
+Allocations per_call(Run &&run) {
+  const std::size_t count = g_allocations.load();
+  const std::size_t bytes = g_bytes.load();
+  for (int rep = 0; rep != k_Repetitions; ++rep) {
+    run();
+  }
+  return {static_cast<double>(g_allocations.load() - count) / k_Repetitions,
+          static_cast<double>(g_bytes.load() - bytes) / k_Repetitions};
+}
+
+void print(std::string_view path, Allocations allocations) {
+  std::printf("%-44.*s %8.1f allocations %10.1f bytes\n",
+              static_cast<int>(path.size()),
+              path.data(),
+              allocations.count,
+              allocations.bytes);
+}
+
+// Report the cost of a build path.
+template <class Run>
+void report(std::string_view path, Run &&run) {
+  print(path, per_call(run));
+}
+
+// Require a lookup path to be allocation-free, once it has run once to build
+// whatever it indexes lazily.
+template <class Run>
+void expect_no_allocations(std::string_view path, Run &&run) {
+  run();
+  const Allocations allocations = per_call(run);
+  print(path, allocations);
+  if (allocations.count != 0) {
+    throw std::runtime_error("allocated on an allocation-free path: " +
+                             std::string(path));
+  }
+}
+
+auto make_switch() {
+  auto sw = StringSwitch<int>::create().on_default(-1);
+  for (int idx = 0; idx != 100; ++idx) {
+    sw.when("label-" + std::to_string(idx), idx);
+  }
+  sw.when(k_LongLabel, 100).when_between("x", "y", 101);
+  return sw;
+}
+
+void test_build_paths() {
+  report("build: late-bound switch, 102 cases", [] { make_switch(); });
+  report("build: early-bound create(short param)", [] {
+    StringSwitch<int>::create("mango").on_default(-1);
+  });
+  report("build: early-bound create(long param)", [] {
+    StringSwitch<int>::create(k_LongLabel).on_default(-1);
+  });
+  report("build: one-shot chain, 3 cases", [] {
+    StringSwitch<Fruit>::create("mango")
+        .when("apple", Fruit::k_Apple)
+        .when("mango", Fruit::k_Mango)
+        .when("orange", Fruit::k_Orange)
+        .on_default(Fruit::k_Invalid)
+        .evaluate();
+  });
+  const auto sw = make_switch();
+  report("build: CompiledSwitch, 102 cases", [&] { CompiledSwitch c(sw); });
+  report("build: flat table, 102 cases", [&] {
+    const auto copy = sw;
+    stringswitch::detail::SwitchAccess::flat_table(copy);
+  });
+}
+
+void test_lookup_paths() {
+  const auto sw = make_switch();
+  expect_no_allocations("evaluate: hit", [&] {
+    assert_equal(sw.evaluate("label-42"), 42);
+  });
+  expect_no_allocations("evaluate: long hit", [&] {
+    assert_equal(sw.evaluate(k_LongLabel), 100);
+  });
+  expect_no_allocations("evaluate: range", [&] {
+    assert_equal(sw.evaluate("xylophone"), 101);
+  });
+  expect_no_allocations("evaluate: miss", [&] {
+    assert_equal(sw.evaluate(std::string_view(k_LongLabel).substr(1)), -1);
+  });
+  expect_no_allocations("evaluate_json_escaped: escaped hit", [&] {
+    assert_equal(sw.evaluate_json_escaped("label-\\u0034\\u0032"), 42);
+  });
+
+  const auto early = StringSwitch<int>::create(k_LongLabel)
+                         .when(k_LongLabel, 1)
+                         .on_default(-1);
+  expect_no_allocations("evaluate: early-bound", [&] {
+    assert_equal(early.evaluate(), 1);
+  });
+
+  const CompiledSwitch compiled(sw);
+  expect_no_allocations("CompiledSwitch::evaluate", [&] {
+    assert_equal(compiled.evaluate(k_LongLabel), 100);
+    assert_equal(compiled.evaluate("label-7"), 7);
+  });
+
+  const TieredSwitch tiered(sw, 1);
+  tiered.promote();
+  expect_no_allocations("TieredSwitch::evaluate", [&] {
+    assert_equal(tiered.evaluate("label-7"), 7);
+  });
+
+  std::vector<std::string_view> batch;
+  for (int idx = 0; idx != 64; ++idx) {
+    batch.push_back(idx % 2 ? k_LongLabel : "missing");
+  }
+  std::vector<int> out(batch.size());
+  expect_no_allocations("evaluate_batch: direct", [&] {
+    stringswitch::evaluate_batch(batch,
+                                 sw,
+                                 std::span(out),
+                                 stringswitch::BatchStrategy::k_Direct);
+  });
+  std::sort(batch.begin(), batch.end());
+  expect_no_allocations("evaluate_batch: merge join", [&] {
+    stringswitch::evaluate_batch(batch,
+                                 sw,
+                                 std::span(out),
+                                 stringswitch::BatchStrategy::k_MergeJoin);
+  });
+}
+
+void test_key_lookup_paths() {
+  const auto normalized =
+      StringSwitch<int, NormalizedKey<TrimWhitespace, FoldCase>>::create()
+          .when(k_LongLabel, 1)
+          .on_default(-1);
+  expect_no_allocations("evaluate: NormalizedKey", [&] {
+    assert_equal(
+        normalized.evaluate("  A LABEL THAT IS MUCH TOO LONG to fit in a "
+                            "small string buffer "),
+        1);
+  });
+
+  // Looks up the parameter normalized at creation, as a label.
+  const auto normalized_early =
+      StringSwitch<int, NormalizedKey<TrimWhitespace, FoldCase>>::create(
+          "  A LABEL THAT IS MUCH TOO LONG to fit in a small string buffer ")
+          .when(k_LongLabel, 1)
+          .on_default(-1);
+  expect_no_allocations("evaluate: NormalizedKey, early-bound", [&] {
+    assert_equal(normalized_early.evaluate(), 1);
+  });
+
+  const auto transcoding = StringSwitch<int, TranscodingKey<char16_t>>::create()
+                               .when("grüße aus München", 1)
+                               .on_default(-1);
+  expect_no_allocations("evaluate: TranscodingKey", [&] {
+    assert_equal(transcoding.evaluate(u"grüße aus München"), 1);
+  });
+
+  const auto canonical = StringSwitch<int, CanonicalKey>::create()
+                             .when(k_LongLabel, 1)
+                             .when("Zürich", 2)
+                             .on_default(-1);
+  expect_no_allocations("evaluate: CanonicalKey", [&] {
+    assert_equal(canonical.evaluate(k_LongLabel), 1);
+    assert_equal(canonical.evaluate("Zürich"), 2);
+  });
+
+  std::array<std::byte, 16> uuid{};
+  uuid[15] = std::byte{1};
+  const auto fixed = StringSwitch<int, FixedKey<16>>::create()
+                         .when(uuid, 1)
+                         .on_default(-1);
+  expect_no_allocations("evaluate: FixedKey<16>", [&] {
+    assert_equal(fixed.evaluate(uuid), 1);
+  });
+
+  RouteSwitch<int> routes;
+  routes.when("/users/{id}/posts", 1);
+  expect_no_allocations("RouteSwitch::match", [&] {
+    assert_true(routes.match("/users/42/posts").has_value());
+  });
+}
+
+} // namespace
+
+int main() {
+  test_build_paths();
+  test_lookup_paths();
+  test_key_lookup_paths();
+}
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_batch.h"
+#include "testing.h"
+
+using stringswitch::StringSwitch;
+
+template <typename Bins, typename Key>
+std::size_t count_of(const Bins &bins, const Key &key) {
+  for (const auto &bin : bins) {
+    if (bin.key == key) {
+      return bin.count;
+    }
+  }
+  throw std::runtime_error("No bin for the requested key.");
+}
+
+template <typename Buckets, typename Key>
+const std::vector<std::size_t> &indices_of(const Buckets &buckets,
+                                           const Key &key) {
+  for (const auto &bucket : buckets) {
+    if (bucket.key == key) {
+      return bucket.indices;
+    }
+  }
+  throw std::runtime_error("No bucket for the requested key.");
+}
+
+std::string numbered_key(std::size_t idx) {
+  std::string digits = std::to_string(idx);
+  return "key-" + std::string(6 - digits.size(), '0') + digits;
+}
+
+template <class Switch>
+std::size_t switcher_size(const Switch &sw) {
+  return stringswitch::detail::SwitchAccess::num_cases(sw);
+}
+
+void test_partition_with_default() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .when("orange", Fruit::k_Orange)
+                      .on_default(Fruit::k_Invalid);
+
+  std::array<std::string_view, 6> in = {
+      "mango", "apple", "bad", "mango", "orange", "worse"};
+  auto buckets = stringswitch::partition(in, switcher);
+
+  assert_equal(buckets.size(), std::size_t{4});
+  assert_true(indices_of(buckets, Fruit::k_Apple) ==
+              std::vector<std::size_t>{1});
+  assert_true(indices_of(buckets, Fruit::k_Mango) ==
+              std::vector<std::size_t>{0, 3});
+  assert_true(indices_of(buckets, Fruit::k_Orange) ==
+              std::vector<std::size_t>{4});
+  assert_true(indices_of(buckets, Fruit::k_Invalid) ==
+              std::vector<std::size_t>{2, 5});
+}
+
+void test_partition_merges_default_with_case() {
+  // The default shares its outcome with a case, so both land in one bucket.
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .on_default(Fruit::k_Apple);
+
+  std::vector<std::string> in = {"apple", "kiwi", "mango"};
+  auto buckets = stringswitch::partition(in, switcher);
+
+  assert_equal(buckets.size(), std::size_t{2});
+  assert_true(indices_of(buckets, Fruit::k_Apple) ==
+              std::vector<std::size_t>{0, 1});
+}
+
+void test_partition_large_batch() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango);
+
+  // Larger than the sample used to size the buckets.
+  std::vector<std::string_view> in;
+  for (std::size_t idx = 0; idx != 5000; ++idx) {
+    in.push_back(idx % 5 == 0 ? "mango" : (idx % 5 == 1 ? "kiwi" : "apple"));
+  }
+  auto buckets = stringswitch::partition(in, switcher);
+
+  assert_equal(indices_of(buckets, std::optional<Fruit>(Fruit::k_Apple)).size(),
+               std::size_t{3000});
+  const auto &mangoes =
+      indices_of(buckets, std::optional<Fruit>(Fruit::k_Mango));
+  assert_equal(mangoes.size(), std::size_t{1000});
+  for (std::size_t idx = 0; idx != mangoes.size(); ++idx) {
+    assert_equal(mangoes[idx], idx * 5);
+  }
+  assert_equal(indices_of(buckets, std::optional<Fruit>()).size(),
+               std::size_t{1000});
+}
+
+void test_histogram_without_default() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .when("orange", Fruit::k_Orange);
+
+  std::array<const char *, 5> in = {"apple", "bad", "apple", "orange", "x"};
+  auto bins = stringswitch::histogram(in, switcher);
+
+  assert_equal(bins.size(), std::size_t{4});
+  assert_equal(count_of(bins, std::optional<Fruit>(Fruit::k_Apple)),
+               std::size_t{2});
+  assert_equal(count_of(bins, std::optional<Fruit>(Fruit::k_Mango)),
+               std::size_t{0});
+  assert_equal(count_of(bins, std::optional<Fruit>(Fruit::k_Orange)),
+               std::size_t{1});
+  assert_equal(count_of(bins, std::optional<Fruit>()), std::size_t{2});
+}
+
+void test_histogram_threads_agree() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .on_default(Fruit::k_Invalid);
+
+  std::vector<std::string_view> in;
+  for (std::size_t idx = 0; idx != 10007; ++idx) {
+    in.push_back(idx % 3 == 0 ? "apple" : (idx % 3 == 1 ? "mango" : "?"));
+  }
+
+  for (std::size_t threads : {1, 2, 3, 8}) {
+    auto bins = stringswitch::histogram(in, switcher, threads);
+    assert_equal(count_of(bins, Fruit::k_Apple), std::size_t{3336});
+    assert_equal(count_of(bins, Fruit::k_Mango), std::size_t{3336});
+    assert_equal(count_of(bins, Fruit::k_Invalid), std::size_t{3335});
+  }
+}
+
+void test_evaluate_batch_strategies_agree() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .when("orange", Fruit::k_Orange);
+
+  // Rows are separate strings, so deduplication has to match on content.
+  std::vector<std::string> in;
+  for (std::size_t idx = 0; idx != 20000; ++idx) {
+    in.push_back(std::array{"apple", "mango", "kiwi", "orange"}[idx % 4]);
+  }
+
+  auto direct = stringswitch::evaluate_batch(
+      in, switcher, stringswitch::BatchStrategy::k_Direct);
+  auto deduplicated = stringswitch::evaluate_batch(
+      in, switcher, stringswitch::BatchStrategy::k_Deduplicate);
+  auto automatic = stringswitch::evaluate_batch(in, switcher);
+
+  assert_equal(direct.size(), in.size());
+  for (std::size_t idx = 0; idx != in.size(); ++idx) {
+    assert_equal(direct[idx], switcher.evaluate(in[idx]));
+    assert_equal(deduplicated[idx], direct[idx]);
+    assert_equal(automatic[idx], direct[idx]);
+  }
+}
+
+void test_evaluate_batch_interned_views() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .on_default(Fruit::k_Invalid);
+
+  // Rows are views into a small dictionary, so they match by identity.
+  std::array<std::string, 3> dictionary = {"mango", "apple", "fig"};
+  std::vector<std::string_view> in;
+  for (std::size_t idx = 0; idx != 4096; ++idx) {
+    in.push_back(dictionary[(idx * 7) % dictionary.size()]);
+  }
+
+  std::vector<Fruit> out(in.size(), Fruit::k_Orange);
+  stringswitch::evaluate_batch(
+      in, switcher, std::span(out), stringswitch::BatchStrategy::k_Deduplicate);
+  for (std::size_t idx = 0; idx != in.size(); ++idx) {
+    assert_equal(out[idx], switcher.evaluate(in[idx]));
+  }
+}
+
+void test_evaluate_batch_high_cardinality() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("7", Fruit::k_Apple)
+                      .when("4095", Fruit::k_Mango)
+                      .on_default(Fruit::k_Invalid);
+
+  // Every row is distinct, so a forced deduplication bails out part way.
+  std::vector<std::string> in;
+  for (std::size_t idx = 0; idx != 8192; ++idx) {
+    in.push_back(std::to_string(idx));
+  }
+
+  for (auto strategy : {stringswitch::BatchStrategy::k_Auto,
+                        stringswitch::BatchStrategy::k_Deduplicate}) {
+    auto out = stringswitch::evaluate_batch(in, switcher, strategy);
+    for (std::size_t idx = 0; idx != in.size(); ++idx) {
+      const Fruit expected =
+          idx == 7 ? Fruit::k_Apple
+                   : (idx == 4095 ? Fruit::k_Mango : Fruit::k_Invalid);
+      assert_equal(out[idx], expected);
+    }
+  }
+}
+
+void test_evaluate_batch_long_labels() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("a.fully.qualified.apple.metric", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .on_default(Fruit::k_Invalid);
+
+  // Mixes rows hashed in vector lanes with rows too long for them.
+  std::vector<std::string_view> in = {"mango",
+                                      "a.fully.qualified.apple.metric",
+                                      "a.fully.qualified.apple.metriC",
+                                      "",
+                                      "mango!"};
+  auto out = stringswitch::evaluate_batch(
+      in, switcher, stringswitch::BatchStrategy::k_Direct);
+  assert_equal(out[0], Fruit::k_Mango);
+  assert_equal(out[1], Fruit::k_Apple);
+  assert_equal(out[2], Fruit::k_Invalid);
+  assert_equal(out[3], Fruit::k_Invalid);
+  assert_equal(out[4], Fruit::k_Invalid);
+}
+
+// Labels "key-000000", "key-000002", ... with the result of each its number.
+auto make_large_switch(std::size_t num_labels) {
+  auto switcher = StringSwitch<std::size_t>::create()
+                      .when_at_least("zzz", std::size_t{1})
+                      .on_default(std::size_t{0});
+  for (std::size_t idx = 0; idx != num_labels; ++idx) {
+    switcher.when(numbered_key(idx * 2), idx * 2);
+  }
+  return switcher;
+}
+
+void test_evaluate_batch_merge_join() {
+  const auto switcher =
+      make_large_switch(stringswitch::detail::k_MergeJoinMinTableSize);
+
+  // Sorted, with duplicates, misses between every label, and rows that fall
+  // in a range past the last label.
+  std::vector<std::string> in = {"", "key-"};
+  for (std::size_t idx = 0; idx != 3 * switcher_size(switcher); idx += 3) {
+    in.push_back(numbered_key(idx));
+    in.push_back(numbered_key(idx));
+  }
+  in.push_back("zzz");
+  in.push_back("zzzz");
+  assert_true(stringswitch::detail::choose_batch_strategy(
+                  in, switcher_size(switcher)) ==
+              stringswitch::BatchStrategy::k_MergeJoin);
+
+  for (auto strategy : {stringswitch::BatchStrategy::k_Auto,
+                        stringswitch::BatchStrategy::k_MergeJoin}) {
+    auto out = stringswitch::evaluate_batch(in, switcher, strategy);
+    for (std::size_t idx = 0; idx != in.size(); ++idx) {
+      assert_equal(out[idx], switcher.evaluate(in[idx]));
+    }
+  }
+
+  // Unsorted batches are not merged by default, but still come out right
+  // when they are.
+  std::reverse(in.begin(), in.end());
+  assert_true(stringswitch::detail::choose_batch_strategy(
+                  in, switcher_size(switcher)) !=
+              stringswitch::BatchStrategy::k_MergeJoin);
+  auto out = stringswitch::evaluate_batch(
+      in, switcher, stringswitch::BatchStrategy::k_MergeJoin);
+  for (std::size_t idx = 0; idx != in.size(); ++idx) {
+    assert_equal(out[idx], switcher.evaluate(in[idx]));
+  }
+}
+
+void test_merge_join_needs_a_dense_batch() {
+  const std::size_t num_labels = stringswitch::detail::k_MergeJoinMinTableSize;
+  std::vector<std::string> sparse;
+  for (std::size_t idx = 0; idx != num_labels; idx += 128) {
+    sparse.push_back(numbered_key(idx));
+  }
+  assert_true(stringswitch::detail::choose_batch_strategy(sparse, num_labels) !=
+              stringswitch::BatchStrategy::k_MergeJoin);
+  // Small tables are probed directly however the batch is ordered.
+  assert_true(stringswitch::detail::choose_batch_strategy(sparse, 1000) !=
+              stringswitch::BatchStrategy::k_MergeJoin);
+}
+
+void test_frozen_table_built_once() {
+  using stringswitch::detail::SwitchAccess;
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango);
+
+  // Threads racing to build the table all get the one that is published.
+  std::vector<const void *> tables(4);
+  std::vector<std::thread> threads;
+  for (std::size_t idx = 0; idx != tables.size(); ++idx) {
+    threads.emplace_back(
+        [&, idx] { tables[idx] = &SwitchAccess::flat_table(switcher); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (const void *table : tables) {
+    assert_true(table == tables[0]);
+  }
+
+  // Copies share it until their cases change.
+  auto copy = switcher;
+  assert_true(&SwitchAccess::flat_table(copy) == tables[0]);
+  copy.when("orange", Fruit::k_Orange);
+  assert_true(SwitchAccess::flat_table(copy).size() == 3);
+  assert_true(&SwitchAccess::flat_table(switcher) == tables[0]);
+  assert_true(SwitchAccess::flat_table(switcher).size() == 2);
+}
+
+void test_batch_with_ranges() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when_between("a", "m", Fruit::k_Apple)
+                      .when_at_least("m", Fruit::k_Mango)
+                      .when("orange", Fruit::k_Orange);
+
+  std::vector<std::string_view> in = {"banana", "orange", "peach", "Apple"};
+  auto bins = stringswitch::histogram(in, switcher);
+  assert_equal(count_of(bins, std::optional<Fruit>(Fruit::k_Apple)),
+               std::size_t{1});
+  assert_equal(count_of(bins, std::optional<Fruit>(Fruit::k_Mango)),
+               std::size_t{1});
+  assert_equal(count_of(bins, std::optional<Fruit>(Fruit::k_Orange)),
+               std::size_t{1});
+  assert_equal(count_of(bins, std::optional<Fruit>()), std::size_t{1});
+
+  auto out = stringswitch::evaluate_batch(in, switcher);
+  for (std::size_t idx = 0; idx != in.size(); ++idx) {
+    assert_equal(out[idx], switcher.evaluate(in[idx]));
+  }
+}
+
+void test_outcome_ordinals_follow_changes() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .on_default(Fruit::k_Invalid);
+
+  // The ordinals of the cases are kept with the switch between calls, and
+  // derived again once its cases or ranges change.
+  std::vector<std::string_view> in = {"apple", "mango", "peach", "kiwi"};
+  assert_equal(stringswitch::histogram(in, switcher).size(), std::size_t{2});
+  switcher.when("mango", Fruit::k_Mango).when_at_least("p", Fruit::k_Orange);
+  auto bins = stringswitch::histogram(in, switcher);
+  assert_equal(bins.size(), std::size_t{4});
+  assert_equal(count_of(bins, Fruit::k_Mango), std::size_t{1});
+  assert_equal(count_of(bins, Fruit::k_Orange), std::size_t{1});
+  assert_equal(count_of(bins, Fruit::k_Invalid), std::size_t{1});
+
+  // A switch given a default shares the ordinals of the switch it came from,
+  // but not its miss.
+  auto partial = StringSwitch<Fruit>::create()
+                     .when("apple", Fruit::k_Apple)
+                     .when("mango", Fruit::k_Mango);
+  assert_equal(stringswitch::histogram(in, partial).size(), std::size_t{3});
+  const auto defaulted = partial.on_default(Fruit::k_Apple);
+  auto buckets = stringswitch::partition(in, defaulted);
+  assert_equal(buckets.size(), std::size_t{2});
+  assert_true(indices_of(buckets, Fruit::k_Apple) ==
+              std::vector<std::size_t>{0, 2, 3});
+  assert_equal(count_of(stringswitch::histogram(in, partial),
+                        std::optional<Fruit>()),
+               std::size_t{2});
+}
+
+void test_empty_batch() {
+  auto switcher = StringSwitch<Fruit>::create().on_default(Fruit::k_Invalid);
+
+  std::vector<std::string_view> in;
+  auto buckets = stringswitch::partition(in, switcher);
+  auto bins = stringswitch::histogram(in, switcher, 4);
+  auto outcomes = stringswitch::evaluate_batch(in, switcher);
+
+  assert_true(outcomes.empty());
+  assert_equal(buckets.size(), std::size_t{1});
+  assert_true(buckets[0].indices.empty());
+  assert_equal(count_of(bins, Fruit::k_Invalid), std::size_t{0});
+}
+
+int main() {
+  test_partition_with_default();
+  test_partition_merges_default_with_case();
+  test_partition_large_batch();
+
+  test_histogram_without_default();
+  test_histogram_threads_agree();
+
+  test_evaluate_batch_strategies_agree();
+  test_evaluate_batch_interned_views();
+  test_evaluate_batch_high_cardinality();
+  test_evaluate_batch_long_labels();
+
+  test_evaluate_batch_merge_join();
+  test_merge_join_needs_a_dense_batch();
+
+  test_frozen_table_built_once();
+
+  test_batch_with_ranges();
+  test_outcome_ordinals_follow_changes();
+
+  test_empty_batch();
+}
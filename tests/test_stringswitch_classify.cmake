@@ -0,0 +1,63 @@
+# Runs stringswitch_classify on small inputs and checks its output.
+#
+#   cmake -DTOOL=<stringswitch_classify> -DWORK_DIR=<scratch dir>
+#         -P test_stringswitch_classify.cmake
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(LABELS ${WORK_DIR}/labels.tsv)
+set(INPUT ${WORK_DIR}/input.csv)
+# CRLF line endings in the label file are not part of the class names.
+file(WRITE ${LABELS} "apple\tfruit\r\nmango\tfruit\r\ncarrot\tvegetable\n")
+# A miss, a record with too few fields and a CRLF line ending.
+file(WRITE ${INPUT} "1,apple\n2,carrot\n3,kiwi\n4\n5,mango\r\n")
+
+function(expect_equal actual expected what)
+  if(NOT actual STREQUAL expected)
+    message(FATAL_ERROR "${what}: expected '${expected}', got '${actual}'")
+  endif()
+endfunction()
+
+# Counts with each backend, with more threads than there are records per
+# chunk, over two inputs.
+foreach(backend compiled batch switch)
+  foreach(threads 1 3)
+    execute_process(
+      COMMAND ${TOOL} --labels ${LABELS} --field 2 --delimiter , --threads
+              ${threads} --backend ${backend} ${INPUT} ${INPUT}
+      OUTPUT_VARIABLE counts
+      ERROR_QUIET
+      RESULT_VARIABLE result
+    )
+    set(what "${backend} backend with ${threads} threads")
+    expect_equal("${result}" "0" "exit status of ${what}")
+    expect_equal(
+      "${counts}"
+      "unmatched\t4\nfruit\t4\nvegetable\t2\n"
+      "counts of ${what}"
+    )
+  endforeach()
+endforeach()
+
+# Class ids, as little-endian 16-bit words in input order.
+execute_process(
+  COMMAND ${TOOL} --labels ${LABELS} --field 2 --delimiter , --threads 2
+          --output column ${INPUT}
+  OUTPUT_FILE ${WORK_DIR}/column.bin
+  ERROR_QUIET
+  RESULT_VARIABLE result
+)
+expect_equal("${result}" "0" "exit status with --output column")
+file(READ ${WORK_DIR}/column.bin column HEX)
+expect_equal("${column}" "01000200000000000100" "class ids")
+
+# Malformed numbers and unknown backends are usage errors.
+foreach(option "--field;-1" "--field;0" "--field;2x" "--threads;4x"
+        "--threads;0" "--threads;99999999999999999999999" "--backend;jit")
+  execute_process(
+    COMMAND ${TOOL} --labels ${LABELS} --field 2 ${option} ${INPUT}
+    OUTPUT_QUIET
+    ERROR_QUIET
+    RESULT_VARIABLE result
+  )
+  expect_equal("${result}" "2" "exit status with ${option}")
+endforeach()
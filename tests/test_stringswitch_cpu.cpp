@@ -0,0 +1,146 @@
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "stringswitch/stringswitch_cpu.h"
+#include "testing.h"
+
+using stringswitch::Isa;
+using stringswitch::detail::HashSlot;
+using stringswitch::detail::k_ProbeGroup;
+using stringswitch::detail::Kernels;
+
+const Isa k_Isas[] = {
+    Isa::k_Scalar, Isa::k_Sse2, Isa::k_Avx2, Isa::k_Avx512};
+
+namespace stringswitch {
+// Found by argument-dependent lookup from `assert_equal`.
+std::ostream &operator<<(std::ostream &os, Isa isa) {
+  return os << static_cast<int>(isa);
+}
+} // namespace stringswitch
+
+void check_equal_bytes(const Kernels &kernels) {
+  for (std::size_t size = 0; size != 200; ++size) {
+    std::string lhs(size, 'x');
+    for (std::size_t idx = 0; idx != size; ++idx) {
+      lhs[idx] = static_cast<char>('a' + (idx * 7) % 26);
+    }
+    assert_true(kernels.equal_bytes(lhs.data(), lhs.data(), size));
+    std::string rhs = lhs;
+    assert_true(kernels.equal_bytes(lhs.data(), rhs.data(), size));
+    // A difference at any position must be noticed.
+    for (std::size_t idx = 0; idx != size; ++idx) {
+      rhs[idx] ^= 0x20;
+      assert_true(!kernels.equal_bytes(lhs.data(), rhs.data(), size));
+      rhs[idx] ^= 0x20;
+    }
+  }
+}
+
+void check_find_byte(const Kernels &kernels) {
+  for (std::size_t size = 0; size != 200; ++size) {
+    std::string data(size, 'a');
+    assert_equal(kernels.find_byte(data.data(), size, '/'), size);
+    for (std::size_t idx = 0; idx != size; ++idx) {
+      data[idx] = '/';
+      assert_equal(kernels.find_byte(data.data(), size, '/'), idx);
+      // An earlier occurrence wins.
+      if (idx + 1 != size) {
+        data[size - 1] = '/';
+        assert_equal(kernels.find_byte(data.data(), size, '/'), idx);
+        data[size - 1] = 'a';
+      }
+      data[idx] = 'a';
+    }
+  }
+}
+
+void check_find_non_ascii(const Kernels &kernels) {
+  for (std::size_t size = 0; size != 200; ++size) {
+    std::string data(size, 'a');
+    assert_equal(kernels.find_non_ascii(data.data(), size), size);
+    for (std::size_t idx = 0; idx != size; ++idx) {
+      for (char byte : {'\x80', '\xC3', '\xFF'}) {
+        data[idx] = byte;
+        assert_equal(kernels.find_non_ascii(data.data(), size), idx);
+      }
+      if (idx + 1 != size) {
+        data[size - 1] = '\xFF';
+        assert_equal(kernels.find_non_ascii(data.data(), size), idx);
+        data[size - 1] = '\x7F';
+      }
+      data[idx] = '\x7F';
+    }
+  }
+}
+
+void check_probe_group(const Kernels &kernels) {
+  HashSlot slots[k_ProbeGroup];
+  for (std::uint32_t pattern = 0; pattern != 256; ++pattern) {
+    for (std::size_t idx = 0; idx != k_ProbeGroup; ++idx) {
+      const bool occupied = (pattern >> idx) & 1;
+      slots[idx] = occupied ? HashSlot{idx % 3 == 0 ? 42u : 7u,
+                                       static_cast<std::uint32_t>(idx + 1)}
+                            : HashSlot{};
+    }
+    for (std::uint32_t hash : {0u, 7u, 42u}) {
+      const auto expected =
+          stringswitch::detail::probe_group_scalar(slots, hash);
+      const auto actual = kernels.probe_group(slots, hash);
+      assert_equal(actual.matches, expected.matches);
+      assert_equal(actual.empties, expected.empties);
+    }
+  }
+}
+
+void check_count_below(const Kernels &kernels) {
+  const std::uint64_t values[stringswitch::detail::k_CountBlock] = {
+      0, 1, 5, 5, 0x7FFFFFFFFFFFFFFFull, 0x8000000000000000ull,
+      0xFFFFFFFFFFFFFFFEull, 0xFFFFFFFFFFFFFFFFull};
+  for (std::uint64_t key : values) {
+    for (std::uint64_t probe : {key, key + 1}) {
+      assert_equal(kernels.count_below(values, probe),
+                   stringswitch::detail::count_below_scalar(values, probe));
+    }
+  }
+  assert_equal(kernels.count_below(values, 5), std::size_t{2});
+  assert_equal(kernels.count_below(values, 0x8000000000000001ull),
+               std::size_t{6});
+}
+
+void test_kernels_agree() {
+  for (Isa isa : k_Isas) {
+    if (isa > stringswitch::detected_isa()) {
+      continue;
+    }
+    const Kernels &kernels = stringswitch::detail::kernels_for(isa);
+    assert_equal(kernels.isa, isa);
+    check_equal_bytes(kernels);
+    check_find_byte(kernels);
+    check_find_non_ascii(kernels);
+    check_probe_group(kernels);
+    check_count_below(kernels);
+  }
+}
+
+void test_force_isa() {
+  const Isa detected = stringswitch::detected_isa();
+
+  assert_equal(stringswitch::force_isa(Isa::k_Scalar), Isa::k_Scalar);
+  assert_equal(stringswitch::active_isa(), Isa::k_Scalar);
+
+  // Forcing an ISA the CPU lacks selects the best one it has.
+  assert_equal(stringswitch::force_isa(Isa::k_Avx512), detected);
+  assert_equal(stringswitch::active_isa(), detected);
+
+  stringswitch::force_isa(Isa::k_Scalar);
+  stringswitch::reset_isa();
+  assert_true(stringswitch::active_isa() <= detected);
+}
+
+int main() {
+  test_kernels_agree();
+  test_force_isa();
+}
@@ -0,0 +1,159 @@
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stringswitch/stringswitch_fields.h"
+#include "testing.h"
+
+using stringswitch::BindStatus;
+using stringswitch::FieldBinder;
+using stringswitch::FieldSet;
+
+namespace stringswitch {
+// Found by argument-dependent lookup from `assert_equal`.
+std::ostream &operator<<(std::ostream &os, BindStatus status) {
+  return os << static_cast<int>(status);
+}
+} // namespace stringswitch
+
+struct Endpoint {
+  std::string host;
+  int port = 80;
+  bool tls = false;
+  double weight = 1.0;
+  std::uint8_t retries = 0;
+  Fruit fruit = Fruit::k_Invalid;
+};
+
+bool parse_fruit(std::string_view text, Fruit &fruit) {
+  if (text == "apple") {
+    fruit = Fruit::k_Apple;
+  } else if (text == "mango") {
+    fruit = Fruit::k_Mango;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+FieldBinder<Endpoint> make_binder() {
+  return FieldBinder<Endpoint>()
+      .required_field("host", &Endpoint::host)
+      .required_field("port", &Endpoint::port)
+      .field("tls", &Endpoint::tls)
+      .field("weight", &Endpoint::weight)
+      .field("retries", &Endpoint::retries)
+      .field("fruit", &Endpoint::fruit, &parse_fruit);
+}
+
+void test_bind_fields() {
+  const auto binder = make_binder();
+  Endpoint endpoint;
+  FieldSet seen;
+
+  assert_equal(binder.bind(endpoint, "host", "example.com", seen),
+               BindStatus::k_Bound);
+  assert_equal(binder.bind(endpoint, "tls", "true", seen), BindStatus::k_Bound);
+  assert_equal(binder.bind(endpoint, "weight", "0.25", seen),
+               BindStatus::k_Bound);
+  assert_equal(binder.bind(endpoint, "retries", "3", seen),
+               BindStatus::k_Bound);
+  assert_equal(binder.bind(endpoint, "fruit", "mango", seen),
+               BindStatus::k_Bound);
+
+  assert_equal(endpoint.host, std::string("example.com"));
+  assert_equal(endpoint.tls, true);
+  assert_equal(endpoint.weight, 0.25);
+  assert_equal(endpoint.retries, std::uint8_t{3});
+  assert_equal(endpoint.fruit, Fruit::k_Mango);
+
+  assert_equal(binder.first_missing(seen),
+               std::optional<std::string_view>("port"));
+  assert_equal(binder.bind(endpoint, "port", "8443", seen),
+               BindStatus::k_Bound);
+  assert_equal(endpoint.port, 8443);
+  assert_true(!binder.first_missing(seen));
+  assert_equal(seen.count(), binder.size());
+}
+
+void test_bind_errors() {
+  const auto binder = make_binder();
+  Endpoint endpoint;
+  FieldSet seen;
+
+  assert_equal(binder.bind(endpoint, "hostname", "x", seen),
+               BindStatus::k_UnknownField);
+  assert_equal(binder.bind(endpoint, "", "x", seen),
+               BindStatus::k_UnknownField);
+  assert_equal(binder.bind(endpoint, "port", "80x", seen),
+               BindStatus::k_InvalidValue);
+  assert_equal(binder.bind(endpoint, "port", "", seen),
+               BindStatus::k_InvalidValue);
+  assert_equal(binder.bind(endpoint, "tls", "yes", seen),
+               BindStatus::k_InvalidValue);
+  assert_equal(binder.bind(endpoint, "retries", "300", seen),
+               BindStatus::k_InvalidValue);
+  assert_equal(binder.bind(endpoint, "fruit", "kiwi", seen),
+               BindStatus::k_InvalidValue);
+  assert_true(seen.none());
+  assert_equal(binder.first_missing(seen),
+               std::optional<std::string_view>("host"));
+
+  bool threw = false;
+  try {
+    make_binder().field("host", &Endpoint::host);
+  } catch (const std::invalid_argument &) {
+    threw = true;
+  }
+  assert_true(threw);
+}
+
+void test_many_fields() {
+  // Every field gets its own perfect hash slot, however many there are.
+  FieldBinder<Endpoint> binder;
+  std::vector<std::string> names;
+  for (std::size_t idx = 0; idx != stringswitch::k_MaxBoundFields; ++idx) {
+    names.push_back("field_" + std::to_string(idx * 7919));
+    binder.field(names.back(), &Endpoint::port);
+  }
+  for (std::size_t idx = 0; idx != names.size(); ++idx) {
+    assert_equal(binder.find(names[idx]), std::optional<std::size_t>(idx));
+    assert_true(!binder.find(names[idx] + "_"));
+  }
+
+  Endpoint endpoint;
+  FieldSet seen;
+  assert_equal(binder.bind(endpoint, names.back(), "7", seen),
+               BindStatus::k_Bound);
+  assert_equal(endpoint.port, 7);
+  assert_true(seen.test(names.size() - 1));
+
+  bool threw = false;
+  try {
+    binder.field("one_too_many", &Endpoint::port);
+  } catch (const std::invalid_argument &) {
+    threw = true;
+  }
+  assert_true(threw);
+}
+
+void test_empty_binder() {
+  FieldBinder<Endpoint> binder;
+  Endpoint endpoint;
+  FieldSet seen;
+  assert_equal(binder.bind(endpoint, "host", "x", seen),
+               BindStatus::k_UnknownField);
+  assert_true(!binder.first_missing(seen));
+}
+
+int main() {
+  test_bind_fields();
+  test_bind_errors();
+  test_many_fields();
+  test_empty_binder();
+}
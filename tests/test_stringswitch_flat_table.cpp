@@ -0,0 +1,209 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "stringswitch/stringswitch_cpu.h"
+#include "stringswitch/stringswitch_flat_table.h"
+#include "stringswitch/stringswitch_hash.h"
+#include "testing.h"
+
+using stringswitch::detail::FlatTable;
+using stringswitch::detail::HashLanes;
+using stringswitch::detail::k_HashLanes;
+
+const stringswitch::Isa k_Isas[] = {stringswitch::Isa::k_Scalar,
+                                    stringswitch::Isa::k_Sse2,
+                                    stringswitch::Isa::k_Avx2,
+                                    stringswitch::Isa::k_Avx512};
+
+std::vector<std::string> make_keys(std::size_t count, std::size_t max_size) {
+  std::vector<std::string> keys;
+  std::uint32_t state = 12345;
+  for (std::size_t idx = 0; idx != count; ++idx) {
+    state = state * 1103515245u + 12345u;
+    std::string key(state % (max_size + 1), '\0');
+    for (char &c : key) {
+      state = state * 1103515245u + 12345u;
+      c = static_cast<char>(state >> 24);
+    }
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+void test_hash_lane_kernels_agree() {
+  auto keys = make_keys(k_HashLanes * 8, 16);
+  for (auto isa : k_Isas) {
+    if (isa > stringswitch::detected_isa()) {
+      continue;
+    }
+    const auto &kernels = stringswitch::detail::kernels_for(isa);
+    for (std::size_t base = 0; base != keys.size(); base += k_HashLanes) {
+      HashLanes lanes;
+      for (std::size_t lane = 0; lane != k_HashLanes; ++lane) {
+        lanes.load(lane, keys[base + lane]);
+      }
+      kernels.hash_short_lanes(lanes);
+      for (std::size_t lane = 0; lane != k_HashLanes; ++lane) {
+        assert_equal(lanes.hashes[lane],
+                     stringswitch::detail::hash_bytes(keys[base + lane]));
+      }
+    }
+  }
+}
+
+void test_hash_is_length_sensitive() {
+  // Overlapping loads must not make keys that differ only in length collide.
+  const std::string_view zeros("\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 17);
+  for (std::size_t size = 0; size != zeros.size(); ++size) {
+    assert_true(stringswitch::detail::hash_bytes(zeros.substr(0, size)) !=
+                stringswitch::detail::hash_bytes(zeros.substr(0, size + 1)));
+  }
+}
+
+void check_find_and_find_group_agree() {
+  auto labels = make_keys(500, 40);
+  FlatTable<std::size_t> table(0);
+  std::vector<std::string> inserted;
+  for (const auto &label : labels) {
+    if (table.find(label) == nullptr) {
+      table.insert(label, inserted.size());
+      inserted.push_back(label);
+    }
+  }
+  assert_equal(table.size(), inserted.size());
+
+  std::vector<std::string_view> queries(inserted.begin(), inserted.end());
+  queries.push_back("not-a-label");
+  queries.push_back("a much longer string that is not a label either");
+  for (std::size_t base = 0; base < queries.size(); base += k_HashLanes) {
+    const std::size_t count = std::min(queries.size() - base, k_HashLanes);
+    const std::size_t *found[k_HashLanes];
+    table.find_group(queries.data() + base, count, found);
+    for (std::size_t lane = 0; lane != count; ++lane) {
+      assert_true(found[lane] == table.find(queries[base + lane]));
+      if (base + lane < inserted.size()) {
+        assert_equal(*found[lane], base + lane);
+      } else {
+        assert_true(found[lane] == nullptr);
+      }
+    }
+  }
+}
+
+void test_find_and_find_group_agree() {
+  for (auto isa : k_Isas) {
+    stringswitch::force_isa(isa);
+    check_find_and_find_group_agree();
+  }
+  stringswitch::reset_isa();
+}
+
+void check_labels_differing_in_one_byte() {
+  // Labels of every size up to 130 bytes, probed with strings of the same
+  // size that differ in one byte. Such probes almost always miss on the hash
+  // already; see `test_hash_equal_candidates` for the paths behind it.
+  FlatTable<std::size_t> table(0);
+  std::vector<std::string> labels;
+  for (std::size_t size = 0; size != 131; ++size) {
+    labels.emplace_back(size, 'm');
+    table.insert(labels.back(), size);
+  }
+  for (const std::string &label : labels) {
+    assert_equal(*table.find(label), label.size());
+    std::string probe = label;
+    for (char &c : probe) {
+      c = 'n';
+      assert_true(table.find(probe) == nullptr);
+      c = 'm';
+    }
+  }
+}
+
+void test_labels_differing_in_one_byte() {
+  for (auto isa : k_Isas) {
+    stringswitch::force_isa(isa);
+    check_labels_differing_in_one_byte();
+  }
+  stringswitch::reset_isa();
+}
+
+// Two distinct labels made of `prefix`, eight varying bytes and `suffix`
+// whose hashes are equal, found by a birthday search over the varying bytes.
+std::pair<std::string, std::string> colliding_labels(std::string_view prefix,
+                                                     std::string_view suffix) {
+  std::unordered_map<std::uint32_t, std::string> seen;
+  for (std::uint64_t counter = 0;; ++counter) {
+    const std::uint64_t varying = counter * 0x9E3779B97F4A7C15ull;
+    std::string label(prefix);
+    label.append(reinterpret_cast<const char *>(&varying), sizeof(varying));
+    label.append(suffix);
+    auto [it, inserted] =
+        seen.try_emplace(stringswitch::detail::hash_bytes(label), label);
+    if (!inserted) {
+      return {it->second, label};
+    }
+  }
+}
+
+void check_hash_equal_candidates(const std::string &first,
+                                 const std::string &second) {
+  FlatTable<int> table(0);
+  table.insert(first, 1);
+  assert_equal(*table.find(first), 1);
+  assert_true(table.find(second) == nullptr);
+  const std::string_view keys[] = {second, first};
+  const int *found[2];
+  table.find_group(keys, 2, found);
+  assert_true(found[0] == nullptr);
+  assert_equal(*found[1], 1);
+
+  table.insert(second, 2);
+  assert_equal(*table.find(first), 1);
+  assert_equal(*table.find(second), 2);
+}
+
+void test_hash_equal_candidates() {
+  // Candidates whose full hash matches the key are told apart by the
+  // fingerprint alone up to 16 bytes, and past that, with the first and last
+  // eight bytes equal, by the compare of the bytes in between.
+  const std::string filler(32, 'x');
+  const std::pair<std::string, std::string> pairs[] = {
+      colliding_labels("", ""),
+      colliding_labels("", "tail"),
+      colliding_labels("head-of-", "-the-end"),
+      colliding_labels("head-of-" + filler, filler + "-the-end"),
+  };
+  for (const auto &[first, second] : pairs) {
+    assert_true(first != second);
+    assert_equal(first.size(), second.size());
+    assert_equal(stringswitch::detail::hash_bytes(first),
+                 stringswitch::detail::hash_bytes(second));
+    if (first.size() > 16) {
+      assert_true(std::memcmp(first.data(), second.data(), 8) == 0);
+      assert_true(std::memcmp(first.data() + first.size() - 8,
+                              second.data() + second.size() - 8,
+                              8) == 0);
+    }
+  }
+  for (auto isa : k_Isas) {
+    stringswitch::force_isa(isa);
+    for (const auto &[first, second] : pairs) {
+      check_hash_equal_candidates(first, second);
+    }
+  }
+  stringswitch::reset_isa();
+}
+
+int main() {
+  test_hash_lane_kernels_agree();
+  test_hash_is_length_sensitive();
+  test_find_and_find_group_agree();
+  test_labels_differing_in_one_byte();
+  test_hash_equal_candidates();
+}
@@ -0,0 +1,147 @@
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_extras.h"
+#include "stringswitch/stringswitch_jit.h"
+#include "testing.h"
+
+using stringswitch::CompiledSwitch;
+using stringswitch::JitMode;
+using stringswitch::StringSwitch;
+
+void test_small_switch() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango)
+                      .when("orange", Fruit::k_Orange);
+
+  for (JitMode mode : {JitMode::k_Auto, JitMode::k_Interpret}) {
+    const CompiledSwitch compiled(switcher, mode);
+    assert_equal(compiled.evaluate("apple"), std::optional(Fruit::k_Apple));
+    assert_equal(compiled.evaluate("mango"), std::optional(Fruit::k_Mango));
+    assert_equal(compiled.evaluate("orange"), std::optional(Fruit::k_Orange));
+    assert_true(!compiled.evaluate("apples"));
+    assert_true(!compiled.evaluate("appla"));
+    assert_true(!compiled.evaluate(""));
+  }
+  assert_true(!CompiledSwitch(switcher, JitMode::k_Interpret).is_native());
+#if STRINGSWITCH_JIT
+  assert_true(CompiledSwitch(switcher).is_native());
+#endif
+}
+
+void test_defaults_and_ranges() {
+  auto switcher = StringSwitch<int>::create().on_default(-1);
+  switcher.when("", 0).when("m", 1).when_between("b", "d", 2);
+
+  const CompiledSwitch compiled(switcher);
+  assert_equal(compiled.evaluate(""), 0);
+  assert_equal(compiled.evaluate("m"), 1);
+  assert_equal(compiled.evaluate("c"), 2);
+  assert_equal(compiled.evaluate("z"), -1);
+
+  // Later changes to the switch are not picked up.
+  switcher.when("z", 3);
+  assert_equal(compiled.evaluate("z"), -1);
+}
+
+void test_without_cases() {
+  auto switcher = StringSwitch<int>::create()
+                      .when_at_least("m", 1)
+                      .when_between("b", "d", 2)
+                      .on_default(-1);
+
+  for (JitMode mode : {JitMode::k_Auto, JitMode::k_Interpret}) {
+    const CompiledSwitch compiled(switcher, mode);
+    assert_equal(compiled.evaluate(""), -1);
+    assert_equal(compiled.evaluate("c"), 2);
+    assert_equal(compiled.evaluate("mango"), 1);
+  }
+
+  const CompiledSwitch only_default(
+      StringSwitch<int>::create().on_default(-1));
+  assert_equal(only_default.evaluate("apple"), -1);
+}
+
+void test_matches_evaluate() {
+  std::uint32_t state = 7;
+  auto next = [&] {
+    state = state * 1103515245 + 12345;
+    return state >> 16;
+  };
+  // Few distinct bytes and a shared prefix, so labels differ in every chunk
+  // and often in just one byte.
+  auto random_word = [&](std::size_t max_size) {
+    std::string word = next() % 2 ? "common/prefix/" : "";
+    word.resize(word.size() + next() % (max_size + 1), 'a');
+    for (std::size_t idx = word.size() - word.size() / 2; idx != word.size();
+         ++idx) {
+      word[idx] = static_cast<char>('a' + next() % 3);
+    }
+    return word;
+  };
+
+  std::set<std::string> unique;
+  for (int idx = 0; idx != 2000; ++idx) {
+    unique.insert(random_word(idx % 10 == 0 ? 70 : 12));
+  }
+  auto switcher = StringSwitch<int>::create().on_default(-1);
+  int result = 0;
+  for (const std::string &label : unique) {
+    switcher.when(label, result++);
+  }
+
+  const CompiledSwitch native(switcher);
+  const CompiledSwitch interpreted(switcher, JitMode::k_Interpret);
+  auto check = [&](std::string_view param) {
+    const int expected = switcher.evaluate(param);
+    assert_equal(native.evaluate(param), expected);
+    assert_equal(interpreted.evaluate(param), expected);
+  };
+  for (const std::string &label : unique) {
+    check(label);
+    // Every single-byte change, as well as truncations and extensions.
+    std::string changed = label;
+    for (char &c : changed) {
+      const char original = c;
+      c = static_cast<char>(original ^ 1);
+      check(changed);
+      c = original;
+    }
+    check(std::string_view(label).substr(0, label.size() / 2));
+    check(label + "a");
+  }
+}
+
+void test_labels_differing_in_the_middle() {
+  // Labels longer than a fingerprint that share their first and last 8 bytes
+  // and their size, so that they share a slot.
+  auto switcher = StringSwitch<int>::create().on_default(-1);
+  std::vector<std::string> labels;
+  for (char c = 'a'; c != 'k'; ++c) {
+    labels.push_back("first8__" + std::string(5, c) + "__last8_");
+    switcher.when(labels.back(), static_cast<int>(labels.size()));
+  }
+
+  for (JitMode mode : {JitMode::k_Auto, JitMode::k_Interpret}) {
+    const CompiledSwitch compiled(switcher, mode);
+    for (std::size_t idx = 0; idx != labels.size(); ++idx) {
+      assert_equal(compiled.evaluate(labels[idx]), static_cast<int>(idx + 1));
+    }
+    assert_equal(compiled.evaluate("first8__zzzzz__last8_"), -1);
+    assert_equal(compiled.evaluate("first8__aaaaa__last8"), -1);
+  }
+}
+
+int main() {
+  test_small_switch();
+  test_defaults_and_ranges();
+  test_without_cases();
+  test_matches_evaluate();
+  test_labels_differing_in_the_middle();
+}
@@ -0,0 +1,42 @@
+#include <optional>
+#include <string_view>
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_complete.h"
+#include "stringswitch/stringswitch_extras.h"
+#include "stringswitch/stringswitch_json.h"
+#include "stringswitch/stringswitch_suggest.h"
+#include "testing.h"
+
+using stringswitch::StringSwitch;
+
+// A result type instantiated the way users instantiate their own.
+STRINGSWITCH_EXTERN_TEMPLATES(Fruit);
+STRINGSWITCH_INSTANTIATE(Fruit);
+
+void test_precompiled_result() {
+  auto switcher = StringSwitch<int>::create().on_default(-1);
+  switcher.when("apple", 1).when("mango", 2).when_at_least("x", 3);
+  assert_equal(switcher.evaluate("apple"), 1);
+  assert_equal(switcher.evaluate("xylophone"), 3);
+  assert_equal(switcher.evaluate("kiwi"), -1);
+  assert_equal(switcher.nearest("aple", 1)->label, std::string_view("apple"));
+
+  auto bound = StringSwitch<unsigned long>::create("mango")
+                   .when("apple", 1ul)
+                   .when("mango", 2ul);
+  assert_equal(bound.evaluate(), std::optional(2ul));
+}
+
+void test_user_instantiated_result() {
+  auto switcher = StringSwitch<Fruit>::create()
+                      .when("apple", Fruit::k_Apple)
+                      .when("mango", Fruit::k_Mango);
+  assert_equal(switcher.evaluate("mango"), std::optional(Fruit::k_Mango));
+  assert_true(!switcher.evaluate("kiwi"));
+}
+
+int main() {
+  test_precompiled_result();
+  test_user_instantiated_result();
+}
@@ -0,0 +1,134 @@
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_cpu.h"
+#include "stringswitch/stringswitch_registry.h"
+#include "testing.h"
+
+using stringswitch::PackedRegistry;
+using stringswitch::StringSwitch;
+
+void test_defaults_and_misses() {
+  PackedRegistry<Fruit> registry;
+  const auto with_default = registry.add(StringSwitch<Fruit>::create()
+                                             .when("apple", Fruit::k_Apple)
+                                             .when("mango", Fruit::k_Mango)
+                                             .on_default(Fruit::k_Invalid));
+  const auto without_default = registry.add(
+      StringSwitch<Fruit>::create().when("apple", Fruit::k_Orange));
+  const auto only_default = registry.add(
+      StringSwitch<Fruit>::create().on_default(Fruit::k_Mango));
+
+  // Switches sharing a label keep their own results.
+  assert_equal(with_default.evaluate("apple"), Fruit::k_Apple);
+  assert_equal(without_default.evaluate("apple"),
+               std::optional(Fruit::k_Orange));
+  assert_equal(with_default.evaluate("mango"), Fruit::k_Mango);
+  assert_equal(with_default.evaluate("kiwi"), Fruit::k_Invalid);
+  assert_true(!without_default.evaluate("mango"));
+  assert_equal(only_default.evaluate("apple"), Fruit::k_Mango);
+
+  assert_equal(registry.num_switches(), std::size_t{3});
+  assert_equal(registry.size(), std::size_t{3});
+}
+
+void check_many_switches_agree() {
+  PackedRegistry<std::uint32_t> registry;
+  std::vector<decltype(StringSwitch<std::uint32_t>::create().on_default(
+      std::uint32_t{0}))>
+      originals;
+  std::vector<decltype(registry.add(originals.front()))> packed;
+  std::uint32_t state = 99;
+  auto next = [&] {
+    state = state * 1103515245u + 12345u;
+    return state >> 8;
+  };
+  for (int idx = 0; idx != 2000; ++idx) {
+    auto sw = StringSwitch<std::uint32_t>::create().on_default(
+        std::uint32_t{0});
+    const std::uint32_t num_cases = next() % 8;
+    for (std::uint32_t label = 0; label != num_cases; ++label) {
+      // Labels repeat across switches, and some are long.
+      sw.when(std::string(label % 3 == 2 ? 40 : 1, 'x') +
+                  std::to_string(next() % 50),
+              next());
+    }
+    packed.push_back(registry.add(sw));
+    originals.push_back(std::move(sw));
+  }
+
+  for (std::size_t idx = 0; idx != originals.size(); ++idx) {
+    for (int label = 0; label != 50; ++label) {
+      for (std::size_t size : {1, 40}) {
+        const std::string param =
+            std::string(size, 'x') + std::to_string(label);
+        assert_equal(packed[idx].evaluate(param),
+                     originals[idx].evaluate(param));
+      }
+    }
+  }
+}
+
+void test_many_switches_agree() {
+  for (auto isa : {stringswitch::Isa::k_Scalar, stringswitch::detected_isa()}) {
+    stringswitch::force_isa(isa);
+    check_many_switches_agree();
+  }
+  stringswitch::reset_isa();
+}
+
+void test_ranges_throw() {
+  PackedRegistry<int> registry;
+  bool threw = false;
+  try {
+    registry.add(StringSwitch<int>::create().when_between("a", "b", 1));
+  } catch (const std::invalid_argument &) {
+    threw = true;
+  }
+  assert_true(threw);
+}
+
+void test_frozen_registry() {
+  PackedRegistry<Fruit> registry;
+  const auto fruits = registry.add(StringSwitch<Fruit>::create()
+                                       .when("orange", Fruit::k_Orange)
+                                       .on_default(Fruit::k_Invalid));
+  registry.freeze();
+  bool threw = false;
+  try {
+    registry.add(StringSwitch<Fruit>::create().when("apple", Fruit::k_Apple));
+  } catch (const std::logic_error &) {
+    threw = true;
+  }
+  assert_true(threw);
+  assert_equal(registry.num_switches(), std::size_t{1});
+
+  // A frozen registry may be shared between threads.
+  std::atomic<int> hits = 0;
+  std::vector<std::thread> threads;
+  for (int idx = 0; idx != 4; ++idx) {
+    threads.emplace_back([&] {
+      for (int lookup = 0; lookup != 1000; ++lookup) {
+        hits += fruits.evaluate("orange") == Fruit::k_Orange &&
+                fruits.evaluate("apple") == Fruit::k_Invalid;
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  assert_equal(hits.load(), 4000);
+}
+
+int main() {
+  test_defaults_and_misses();
+  test_many_switches_agree();
+  test_ranges_throw();
+  test_frozen_registry();
+}
@@ -0,0 +1,153 @@
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "stringswitch/stringswitch_routes.h"
+#include "testing.h"
+
+using stringswitch::RouteSwitch;
+
+enum class Handler { k_Users, k_User, k_Me, k_Posts, k_Post, k_Static };
+
+std::ostream &operator<<(std::ostream &os, Handler handler) {
+  return os << static_cast<int>(handler);
+}
+
+RouteSwitch<Handler> make_routes() {
+  return RouteSwitch<Handler>()
+      .when("/users", Handler::k_Users)
+      .when("/users/{id}", Handler::k_User)
+      .when("/users/me", Handler::k_Me)
+      .when("/users/{id}/posts", Handler::k_Posts)
+      .when("/users/{user}/posts/{post}", Handler::k_Post)
+      .when("/static/*", Handler::k_Static);
+}
+
+std::optional<Handler> handler_of(const RouteSwitch<Handler> &routes,
+                                  std::string_view path) {
+  if (auto match = routes.match(path)) {
+    return match->result();
+  }
+  return std::nullopt;
+}
+
+void test_static_routes() {
+  auto routes = make_routes();
+  assert_equal(handler_of(routes, "/users"), std::optional(Handler::k_Users));
+  assert_equal(handler_of(routes, "/users/me"), std::optional(Handler::k_Me));
+  assert_equal(routes.match("/users")->num_captures(), std::size_t{0});
+
+  // Trailing slashes and empty segments are significant.
+  assert_true(!routes.match("/users/"));
+  assert_true(!routes.match("users"));
+  assert_true(!routes.match(""));
+  assert_true(!routes.match("/"));
+}
+
+void test_captures() {
+  auto routes = make_routes();
+
+  auto user = routes.match("/users/42");
+  assert_true(user.has_value());
+  assert_equal(user->result(), Handler::k_User);
+  assert_equal(user->num_captures(), std::size_t{1});
+  assert_equal(user->capture(0), std::string_view("42"));
+  assert_equal(user->capture("id"), std::optional<std::string_view>("42"));
+  assert_true(!user->capture("post"));
+
+  auto post = routes.match("/users/ada/posts/7");
+  assert_true(post.has_value());
+  assert_equal(post->result(), Handler::k_Post);
+  assert_equal(post->capture("user"), std::optional<std::string_view>("ada"));
+  assert_equal(post->capture("post"), std::optional<std::string_view>("7"));
+
+  // Captures point into the matched path.
+  const std::string path = "/users/1234/posts";
+  auto posts = routes.match(path);
+  assert_true(posts->capture(0).data() == path.data() + 7);
+}
+
+void test_priority() {
+  auto routes = make_routes();
+  // A literal beats a capture...
+  assert_equal(handler_of(routes, "/users/me"), std::optional(Handler::k_Me));
+  // ...unless the literal branch fails further down.
+  auto posts = routes.match("/users/me/posts");
+  assert_true(posts.has_value());
+  assert_equal(posts->result(), Handler::k_Posts);
+  assert_equal(posts->capture("id"), std::optional<std::string_view>("me"));
+
+  // Captures don't match empty segments.
+  assert_true(!routes.match("/users//posts"));
+  assert_true(!routes.match("/users/42/comments"));
+
+  // A capture beats a wildcard, and a wildcard catches what's left.
+  auto fallback = RouteSwitch<Handler>()
+                      .when("/files/{name}", Handler::k_Post)
+                      .when("/files/*", Handler::k_Static);
+  assert_equal(handler_of(fallback, "/files/a.txt"),
+               std::optional(Handler::k_Post));
+  assert_equal(handler_of(fallback, "/files/dir/a.txt"),
+               std::optional(Handler::k_Static));
+  assert_equal(handler_of(fallback, "/files/"),
+               std::optional(Handler::k_Static));
+}
+
+void test_wildcard() {
+  auto routes = make_routes();
+  auto asset = routes.match("/static/css/site.css");
+  assert_true(asset.has_value());
+  assert_equal(asset->result(), Handler::k_Static);
+  assert_equal(asset->capture("*"),
+               std::optional<std::string_view>("css/site.css"));
+  assert_equal(routes.match("/static/")->capture(0), std::string_view(""));
+  assert_true(!routes.match("/static"));
+}
+
+void test_long_segments() {
+  // Segments longer than a vector register, so the separator search has to
+  // cross chunks.
+  const std::string id(100, 'x');
+  const std::string post(37, 'y');
+  auto routes = make_routes();
+  const std::string path = "/users/" + id + "/posts/" + post;
+  auto match = routes.match(path);
+  assert_true(match.has_value());
+  assert_equal(match->capture("user"), std::optional<std::string_view>(id));
+  assert_equal(match->capture("post"), std::optional<std::string_view>(post));
+}
+
+void test_invalid_routes_throw() {
+  auto routes = make_routes();
+  auto throws = [&](std::string_view pattern) {
+    try {
+      routes.when(pattern, Handler::k_Users);
+    } catch (const std::invalid_argument &) {
+      return true;
+    }
+    return false;
+  };
+  assert_true(throws("/users/{id}"));
+  // Capture names don't tell routes apart.
+  assert_true(throws("/users/{name}"));
+  assert_true(throws("/static/*"));
+  assert_true(throws("/static/*/more"));
+  assert_true(throws("/users/{id"));
+  assert_true(throws("/users/{}"));
+  assert_true(throws("/users/a*"));
+  assert_true(throws("/{a}/{b}/{c}/{d}/{e}/{f}/{g}/{h}/{i}"));
+
+  // The failed attempts leave the existing routes intact.
+  assert_equal(handler_of(routes, "/users/42"), std::optional(Handler::k_User));
+  assert_true(!routes.match("/a/b/c/d/e/f/g/h/i"));
+}
+
+int main() {
+  test_static_routes();
+  test_captures();
+  test_priority();
+  test_wildcard();
+  test_long_segments();
+  test_invalid_routes_throw();
+}
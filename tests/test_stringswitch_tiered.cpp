@@ -0,0 +1,135 @@
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_extras.h"
+#include "stringswitch/stringswitch_tiered.h"
+#include "testing.h"
+
+using stringswitch::StringSwitch;
+using stringswitch::TieredSwitch;
+
+auto make_switch() {
+  return StringSwitch<Fruit>::create()
+      .when("apple", Fruit::k_Apple)
+      .when("mango", Fruit::k_Mango)
+      .when_at_least("x", Fruit::k_Orange);
+}
+
+void check_results(const TieredSwitch<decltype(make_switch())> &tiered) {
+  assert_equal(tiered.evaluate("apple"), std::optional(Fruit::k_Apple));
+  assert_equal(tiered.evaluate("mango"), std::optional(Fruit::k_Mango));
+  assert_equal(tiered.evaluate("xylophone"), std::optional(Fruit::k_Orange));
+  assert_true(!tiered.evaluate("kiwi"));
+}
+
+// Wait for the background compilation, failing after a generous timeout.
+template <class Tiered>
+void wait_for_promotion(const Tiered &tiered) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!tiered.is_promoted()) {
+    assert_true(std::chrono::steady_clock::now() < deadline);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void test_stays_unpromoted_below_threshold() {
+  const TieredSwitch tiered(make_switch(), 100);
+  for (int round = 0; round != 24; ++round) {
+    check_results(tiered);
+  }
+  assert_true(!tiered.is_promoted());
+}
+
+void test_promotes_past_threshold() {
+  const TieredSwitch tiered(make_switch(), 100);
+  for (int round = 0; round != 25; ++round) {
+    check_results(tiered);
+  }
+  wait_for_promotion(tiered);
+  check_results(tiered);
+}
+
+void test_explicit_promotion() {
+  const TieredSwitch tiered(make_switch());
+  tiered.promote();
+  assert_true(tiered.is_promoted());
+  check_results(tiered);
+  // Promoting again is harmless.
+  tiered.promote();
+  check_results(tiered);
+}
+
+void test_zero_threshold_promotes_at_once() {
+  const TieredSwitch tiered(make_switch(), 0);
+  assert_true(tiered.is_promoted());
+  check_results(tiered);
+}
+
+void test_takes_the_switch_by_value() {
+  auto sw = make_switch();
+  const TieredSwitch moved(std::move(sw), 1);
+  check_results(moved);
+  wait_for_promotion(moved);
+  check_results(moved);
+
+  // A copy is independent of later changes to the original.
+  auto original = make_switch();
+  const TieredSwitch copied(original, 0);
+  original.when("kiwi", Fruit::k_Apple);
+  assert_true(!copied.evaluate("kiwi"));
+}
+
+void test_concurrent_lookups_during_promotion() {
+  auto sw = StringSwitch<int>::create().on_default(-1);
+  std::vector<std::string> labels;
+  for (int idx = 0; idx != 5000; ++idx) {
+    labels.push_back("label-" + std::to_string(idx * 7919));
+    sw.when(labels.back(), idx);
+  }
+  const TieredSwitch tiered(sw, 1000);
+
+  std::vector<std::thread> threads;
+  std::vector<int> failures(4);
+  for (std::size_t t = 0; t != failures.size(); ++t) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round != 3; ++round) {
+        for (int idx = 0; idx != 5000; ++idx) {
+          failures[t] += tiered.evaluate(labels[idx]) != idx;
+          failures[t] += tiered.evaluate("missing") != -1;
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  for (int failed : failures) {
+    assert_equal(failed, 0);
+  }
+  wait_for_promotion(tiered);
+}
+
+void test_destroyed_while_compiling() {
+  // The destructor waits for the background thread.
+  for (int round = 0; round != 20; ++round) {
+    const TieredSwitch tiered(make_switch(), 1);
+    check_results(tiered);
+  }
+}
+
+int main() {
+  test_stays_unpromoted_below_threshold();
+  test_promotes_past_threshold();
+  test_explicit_promotion();
+  test_zero_threshold_promotes_at_once();
+  test_takes_the_switch_by_value();
+  test_concurrent_lookups_during_promotion();
+  test_destroyed_while_compiling();
+}
@@ -0,0 +1,58 @@
+#ifndef INCLUDED_STRINGSWITCH_TESTS_TESTING_H
+#define INCLUDED_STRINGSWITCH_TESTS_TESTING_H
+
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+enum class Fruit { k_Apple = 0, k_Mango, k_Orange, k_Invalid = -1 };
+
+inline std::ostream &operator<<(std::ostream &os, const Fruit &fruit) {
+  switch (fruit) {
+  case Fruit::k_Apple:
+    os << "Fruit::k_Apple";
+    break;
+  case Fruit::k_Mango:
+    os << "Fruit::k_Mango";
+    break;
+  case Fruit::k_Orange:
+    os << "Fruit::k_Orange";
+    break;
+  case Fruit::k_Invalid:
+    os << "Fruit::k_Invalid";
+    break;
+  }
+  return os;
+}
+
+template <typename T>
+std::ostream &operator<<(std::ostream &os, const std::optional<T> &elem) {
+  if (elem.has_value()) {
+    os << "(" << elem.value() << ")";
+  } else {
+    os << "<nullopt>";
+  }
+  return os;
+}
+
+template <typename T>
+void assert_equal(const T &left, const T &right) {
+  if (left != right) {
+    std::stringstream message;
+    message << "The operands provided did not compare equal: \n\t" << left
+            << " != " << right;
+    throw std::runtime_error(message.str());
+  }
+}
+
+template <typename T>
+void assert_true(const T &value) {
+  if (!value) {
+    std::stringstream message;
+    message << "Expected argument to evaluate to true, but got false.";
+    throw std::runtime_error(message.str());
+  }
+}
+
+#endif // INCLUDED_STRINGSWITCH_TESTS_TESTING_H
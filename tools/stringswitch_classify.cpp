@@ -0,0 +1,461 @@
+// stringswitch_classify: classify one field of every record of large files
+// against a switch loaded from a label file.
+//
+//   stringswitch_classify --labels FILE --field N [--delimiter C]
+//                         [--threads N] [--output counts|column]
+//                         [--backend compiled|batch|switch] INPUT...
+//
+// The label file holds one `label<TAB>class` pair per line. Records are the
+// lines of each input, split into fields on the delimiter (a tab by default);
+// `--field` counts from 1. Records whose field matches no label, or that have
+// too few fields, are classified as `unmatched`.
+//
+// `--output counts` (the default) prints `class<TAB>count` lines. `--output
+// column` writes one little-endian 16-bit class id per record to stdout, in
+// input order: 0 for `unmatched`, then the classes in order of first
+// appearance in the label file. Throughput is reported on stderr.
+//
+// `--backend` picks how fields are looked up: `compiled` (the default) uses a
+// `CompiledSwitch`, `batch` passes blocks of fields to `evaluate_batch`, and
+// `switch` calls `evaluate` on the switch itself.
+//
+// Inputs are memory mapped with sequential read-ahead, and each is split on
+// line boundaries into one contiguous chunk per worker.
+
+#include "stringswitch/stringswitch.h"
+#include "stringswitch/stringswitch_batch.h"
+#include "stringswitch/stringswitch_jit.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Switch = decltype(stringswitch::StringSwitch<std::uint16_t>::create()
+                            .on_default(std::uint16_t{0}));
+
+constexpr std::size_t k_MaxField = 1 << 20;
+constexpr std::size_t k_MaxThreads = 1024;
+// Records are classified this many at a time.
+constexpr std::size_t k_BlockRecords = 1024;
+
+enum class Backend { k_Compiled, k_Batch, k_Switch };
+
+struct Options {
+  std::string labels;
+  std::size_t field = 0;
+  char delimiter = '\t';
+  std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  bool column = false;
+  Backend backend = Backend::k_Compiled;
+  std::vector<std::string> inputs;
+};
+
+[[noreturn]] void usage(const char *message) {
+  std::cerr << "stringswitch_classify: " << message << "\n"
+            << "usage: stringswitch_classify --labels FILE --field N "
+               "[--delimiter C] [--threads N] [--output counts|column] "
+               "[--backend compiled|batch|switch] INPUT...\n";
+  std::exit(2);
+}
+
+// Parses all of `text` as a whole number in `[1, max]`.
+std::size_t parse_count(std::string_view text,
+                        std::size_t max,
+                        const char *message) {
+  std::size_t count = 0;
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), count);
+  if (error != std::errc() || end != text.data() + text.size() || count == 0 ||
+      count > max) {
+    usage(message);
+  }
+  return count;
+}
+
+Options parse_options(int argc, char **argv) {
+  Options options;
+  for (int idx = 1; idx < argc; ++idx) {
+    const std::string_view arg = argv[idx];
+    auto value = [&]() -> std::string_view {
+      if (idx + 1 == argc) {
+        usage("missing option value");
+      }
+      return argv[++idx];
+    };
+    if (arg == "--labels") {
+      options.labels = value();
+    } else if (arg == "--field") {
+      options.field = parse_count(
+          value(), k_MaxField, "the field must be a number from 1");
+    } else if (arg == "--delimiter") {
+      const std::string_view delimiter = value();
+      if (delimiter.size() != 1) {
+        usage("the delimiter must be a single byte");
+      }
+      options.delimiter = delimiter[0];
+    } else if (arg == "--threads") {
+      options.threads = parse_count(
+          value(), k_MaxThreads, "the thread count must be from 1 to 1024");
+    } else if (arg == "--output") {
+      const std::string_view output = value();
+      if (output != "counts" && output != "column") {
+        usage("unknown output");
+      }
+      options.column = output == "column";
+    } else if (arg == "--backend") {
+      const std::string_view backend = value();
+      if (backend == "compiled") {
+        options.backend = Backend::k_Compiled;
+      } else if (backend == "batch") {
+        options.backend = Backend::k_Batch;
+      } else if (backend == "switch") {
+        options.backend = Backend::k_Switch;
+      } else {
+        usage("unknown backend");
+      }
+    } else if (arg.starts_with("--")) {
+      usage("unknown option");
+    } else {
+      options.inputs.emplace_back(arg);
+    }
+  }
+  if (options.labels.empty() || options.field == 0 || options.inputs.empty()) {
+    usage("--labels, --field and at least one input are required");
+  }
+  return options;
+}
+
+// Builds the switch from the label file, numbering classes from 1.
+Switch load_labels(const std::string &path,
+                   std::vector<std::string> &class_names) {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  class_names = {"unmatched"};
+  std::unordered_map<std::string, std::uint16_t> class_ids;
+  auto sw = stringswitch::StringSwitch<std::uint16_t>::create().on_default(
+      std::uint16_t{0});
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.ends_with('\r')) {
+      line.pop_back();
+    }
+    const std::size_t tab = line.find('\t');
+    if (line.empty() || tab == std::string::npos) {
+      continue;
+    }
+    const std::string name = line.substr(tab + 1);
+    auto [it, inserted] = class_ids.try_emplace(
+        name, static_cast<std::uint16_t>(class_names.size()));
+    if (inserted) {
+      if (class_names.size() == UINT16_MAX) {
+        throw std::runtime_error("too many classes in " + path);
+      }
+      class_names.push_back(name);
+    }
+    sw.when(std::string_view(line).substr(0, tab), it->second);
+  }
+  return sw;
+}
+
+// A read-only mapping of a whole file.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("cannot open " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+      ::close(fd);
+      throw std::runtime_error("cannot stat " + path);
+    }
+    d_size = static_cast<std::size_t>(info.st_size);
+    if (d_size != 0) {
+      void *data = ::mmap(nullptr, d_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("cannot map " + path);
+      }
+      // Ask for aggressive read-ahead: every worker streams through its
+      // chunk once. Advice values are not flags, so give them one at a time.
+      ::madvise(data, d_size, MADV_SEQUENTIAL);
+      ::madvise(data, d_size, MADV_WILLNEED);
+      d_data = static_cast<const char *>(data);
+    }
+    ::close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if (d_data != nullptr) {
+      ::munmap(const_cast<char *>(d_data), d_size);
+    }
+  }
+
+  std::string_view contents() const { return {d_data, d_size}; }
+
+private:
+  const char *d_data = nullptr;
+  std::size_t d_size = 0;
+};
+
+// The field of `record` at zero-based `index`, if it has that many.
+bool find_field(std::string_view record,
+                std::size_t index,
+                char delimiter,
+                std::string_view &field) {
+  std::size_t begin = 0;
+  for (; index != 0; --index) {
+    const void *next =
+        std::memchr(record.data() + begin, delimiter, record.size() - begin);
+    if (next == nullptr) {
+      return false;
+    }
+    begin = static_cast<const char *>(next) - record.data() + 1;
+  }
+  const void *end =
+      std::memchr(record.data() + begin, delimiter, record.size() - begin);
+  field = record.substr(begin,
+                        end == nullptr
+                            ? std::string_view::npos
+                            : static_cast<const char *>(end) - record.data() -
+                                  begin);
+  return true;
+}
+
+// Looks up fields with the backend chosen by `--backend`.
+class Classifier {
+public:
+  Classifier(Switch sw, Backend backend)
+      : d_switch(std::move(sw)), d_backend(backend) {
+    if (d_backend == Backend::k_Compiled) {
+      d_compiled.emplace(d_switch);
+    }
+  }
+
+  // Classify `fields` into the same positions of `ids`.
+  void classify(std::span<const std::string_view> fields,
+                std::span<std::uint16_t> ids) const {
+    switch (d_backend) {
+    case Backend::k_Compiled:
+      for (std::size_t idx = 0; idx != fields.size(); ++idx) {
+        ids[idx] = d_compiled->evaluate(fields[idx]);
+      }
+      return;
+    case Backend::k_Batch:
+      stringswitch::evaluate_batch(fields, d_switch, ids);
+      return;
+    case Backend::k_Switch:
+      for (std::size_t idx = 0; idx != fields.size(); ++idx) {
+        ids[idx] = d_switch.evaluate(fields[idx]);
+      }
+      return;
+    }
+  }
+
+  const char *name() const {
+    switch (d_backend) {
+    case Backend::k_Compiled:
+      return d_compiled->is_native() ? "compiled, native"
+                                     : "compiled, interpreted";
+    case Backend::k_Batch:
+      return "batch";
+    case Backend::k_Switch:
+      return "switch";
+    }
+    return "";
+  }
+
+private:
+  Switch d_switch;
+  Backend d_backend;
+  std::optional<stringswitch::CompiledSwitch<Switch>> d_compiled;
+};
+
+// Classifies the records of one chunk of an input, a block of records at a
+// time.
+//
+// Workers sit side by side in one vector, so `run` counts into locals and
+// stores its results once at the end: updating the members per record would
+// bounce cache lines shared with the neighbouring workers.
+struct Worker {
+  std::vector<std::size_t> counts;
+  std::vector<std::uint16_t> column;
+  std::size_t records = 0;
+
+  void run(std::string_view chunk,
+           const Classifier &classifier,
+           const Options &options,
+           std::size_t num_classes) {
+    const std::size_t field_index = options.field - 1;
+    std::vector<std::size_t> local_counts(num_classes);
+    std::vector<std::uint16_t> local_column;
+    std::size_t local_records = 0;
+    // The fields found in the current block, and the record each is from.
+    std::vector<std::string_view> fields;
+    std::vector<std::uint16_t> field_ids(k_BlockRecords);
+    std::vector<std::size_t> field_records;
+    // Records without the field stay `unmatched`.
+    std::vector<std::uint16_t> ids(k_BlockRecords);
+    std::size_t block_records = 0;
+    auto flush = [&] {
+      classifier.classify(fields, std::span(field_ids).first(fields.size()));
+      for (std::size_t idx = 0; idx != fields.size(); ++idx) {
+        ids[field_records[idx]] = field_ids[idx];
+      }
+      for (std::size_t idx = 0; idx != block_records; ++idx) {
+        if (options.column) {
+          local_column.push_back(ids[idx]);
+        } else {
+          ++local_counts[ids[idx]];
+        }
+      }
+      std::fill_n(ids.begin(), block_records, std::uint16_t{0});
+      local_records += block_records;
+      block_records = 0;
+      fields.clear();
+      field_records.clear();
+    };
+    while (!chunk.empty()) {
+      const std::size_t newline = chunk.find('\n');
+      std::string_view record = chunk.substr(0, newline);
+      chunk.remove_prefix(newline == std::string_view::npos ? chunk.size()
+                                                            : newline + 1);
+      if (record.ends_with('\r')) {
+        record.remove_suffix(1);
+      }
+      std::string_view field;
+      if (find_field(record, field_index, options.delimiter, field)) {
+        fields.push_back(field);
+        field_records.push_back(block_records);
+      }
+      if (++block_records == k_BlockRecords) {
+        flush();
+      }
+    }
+    flush();
+    counts = std::move(local_counts);
+    column = std::move(local_column);
+    records = local_records;
+  }
+};
+
+// Split `contents` into up to `parts` chunks that end on line boundaries.
+std::vector<std::string_view> split_lines(std::string_view contents,
+                                          std::size_t parts) {
+  std::vector<std::string_view> chunks;
+  std::size_t begin = 0;
+  for (std::size_t part = 1; part <= parts && begin != contents.size();
+       ++part) {
+    std::size_t end = contents.size() * part / parts;
+    if (end < begin) {
+      end = begin;
+    }
+    if (part != parts) {
+      const std::size_t newline = contents.find('\n', end);
+      end = newline == std::string_view::npos ? contents.size() : newline + 1;
+    } else {
+      end = contents.size();
+    }
+    chunks.push_back(contents.substr(begin, end - begin));
+    begin = end;
+  }
+  return chunks;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Options options = parse_options(argc, argv);
+  try {
+    std::vector<std::string> class_names;
+    const Classifier classifier(load_labels(options.labels, class_names),
+                                options.backend);
+
+    std::vector<std::size_t> totals(class_names.size());
+    std::size_t bytes = 0;
+    std::size_t records = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const std::string &input : options.inputs) {
+      const MappedFile file(input);
+      const std::vector<std::string_view> chunks =
+          split_lines(file.contents(), options.threads);
+      std::vector<Worker> workers(chunks.size());
+      std::vector<std::thread> threads;
+      for (std::size_t idx = 0; idx != chunks.size(); ++idx) {
+        threads.emplace_back([&, idx] {
+          workers[idx].run(
+              chunks[idx], classifier, options, class_names.size());
+        });
+      }
+      for (std::thread &thread : threads) {
+        thread.join();
+      }
+      for (const Worker &worker : workers) {
+        records += worker.records;
+        if (options.column) {
+          std::fwrite(worker.column.data(),
+                      sizeof(std::uint16_t),
+                      worker.column.size(),
+                      stdout);
+        } else {
+          for (std::size_t id = 0; id != totals.size(); ++id) {
+            totals[id] += worker.counts[id];
+          }
+        }
+      }
+      bytes += file.contents().size();
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    // Millions per second; a run too short to time reports zero.
+    auto rate = [&](std::size_t amount) {
+      return elapsed.count() > 0 ? amount / elapsed.count() / 1e6 : 0.0;
+    };
+
+    if (!options.column) {
+      for (std::size_t id = 0; id != totals.size(); ++id) {
+        std::cout << class_names[id] << '\t' << totals[id] << '\n';
+      }
+    }
+    std::fprintf(stderr,
+                 "%zu records, %zu bytes in %.3f s: %.1f MB/s, %.1f M "
+                 "records/s (%s)\n",
+                 records,
+                 bytes,
+                 elapsed.count(),
+                 rate(bytes),
+                 rate(records),
+                 classifier.name());
+  } catch (const std::exception &error) {
+    std::cerr << "stringswitch_classify: " << error.what() << "\n";
+    return 1;
+  }
+  return 0;
+}